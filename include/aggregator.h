@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "result_record_struct.h"
+#include "result_response_struct.h"
+#include "spsc_ring_buffer.h"
+#include "statistics.h"
+
+/**
+ * \class Aggregator
+ * \brief Collects the results of all workers on a single thread
+ * \details Each worker (producer) gets its own lock-free ring buffer. The aggregator thread drains the
+ * ring buffers into the statistics (histograms and time series), the optional raw log and verbose output.
+ * Error messages and the verbose response output use a second ring buffer per worker, so only the aggregator
+ * thread writes to the console.
+ * With a warm-up, the measurement only starts when all connections finished their warm-up. The warm-up results
+ * are collected separately. The measurement ends when the last connection finished its requests.
+ */
+class Aggregator
+{
+public:
+  explicit Aggregator(std::size_t producers, bool verbose, std::ostream* raw_log);
+  virtual ~Aggregator();
+
+  void start(std::size_t warmup_connections = 0);
+  void stop();
+  void push(std::size_t producer, const ResultResponse& result, bool warmup = false);
+  void finish_warmup();
+  void finish_connection();
+
+  /**
+   * \brief True when the measurement started (all connections finished the warm-up)
+   */
+  bool measuring() const
+  {
+    return measuring_.load(std::memory_order_acquire);
+  }
+  /**
+   * \brief Start of the measurement, only valid when measuring
+   */
+  std::chrono::steady_clock::time_point measurement_start() const
+  {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(measurement_start_.load(std::memory_order_relaxed)));
+  }
+
+  /**
+   * \brief Number of measured results processed so far (can be called during the run)
+   */
+  std::uint64_t processed() const
+  {
+    return processed_.load(std::memory_order_relaxed);
+  }
+  /**
+   * \brief Collected statistics, only valid after stop()
+   */
+  const Statistics& statistics() const
+  {
+    return statistics_;
+  }
+  /**
+   * \brief Collected statistics of the warm-up, only valid after stop()
+   */
+  const Statistics& warmup_statistics() const
+  {
+    return warmup_statistics_;
+  }
+
+private:
+  static constexpr std::size_t ring_capacity_ = 8192;
+  using Ring = SpscRingBuffer<ResultRecord, ring_capacity_>;
+  static constexpr std::size_t message_ring_capacity_ = 1024;
+  using MessageRing = SpscRingBuffer<std::string, message_ring_capacity_>;
+
+  bool verbose_;
+  std::ostream* raw_log_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  std::vector<std::unique_ptr<MessageRing>> message_rings_;
+  Statistics statistics_;
+  Statistics warmup_statistics_;
+  std::chrono::steady_clock::time_point start_time_point_;
+  std::atomic<std::chrono::steady_clock::rep> measurement_start_ = 0;
+  std::atomic<std::chrono::steady_clock::rep> measurement_end_ = 0; // Zero until a connection finished
+  std::atomic<std::uint64_t> measurement_allocations_ = 0; // Heap allocation count at the start of the measurement
+  std::atomic<std::size_t> warmup_connections_ = 0; // Connections still warming up
+  std::atomic<bool> measuring_ = false;
+  std::atomic<bool> running_ = false;
+  std::atomic<std::uint64_t> processed_ = 0;
+  std::thread thread_;
+
+  void run();
+  std::size_t drain();
+  void process(const ResultRecord& record, const std::string& message);
+  static std::string verbose_response(const Reply& reply);
+  static const char* status_name(ResultStatus status);
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * \class AllocationCounter
+ * \brief Counts the heap allocations (operator new) of the worker threads, used by the benchmark to catch regressions
+ * \details Only available when build with the COUNT_ALLOCATIONS option, which replaces the global operator new.
+ * Allocations done by OpenSSL (malloc) are not counted. Class can not be an object.
+ */
+class AllocationCounter
+{
+public:
+  static bool enabled();
+  static void track_current_thread();
+  static std::uint64_t count();
+
+private:
+  AllocationCounter() = delete;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "comparison_struct.h"
+#include "histogram.h"
+
+// Forward declaration
+class Statistics;
+
+/**
+ * \class Baseline
+ * \brief Summary and histograms of one or more test runs, used to detect regressions between runs
+ * \details Stored in a compact binary format (variable length integers, only the non-empty histogram buckets).
+ * Multiple runs can be merged into a single baseline. Every metric has its own test: throughput and each latency metric
+ * are tested with Welch's t-test on the values of every second (eg. the p99 latency within each second), the error rate
+ * with a two-proportion z-test. A metric with too few values (seconds) can not be tested, this fails the comparison.
+ */
+class Baseline
+{
+public:
+  Baseline() = default;
+  explicit Baseline(const Statistics& statistics, std::chrono::duration<double, std::milli> duration);
+
+  bool save(const std::string& file) const;
+  bool load(const std::string& file);
+  void merge(const Baseline& other);
+  Comparison compare(const Baseline& current, double threshold, double noise_floor) const;
+
+  double requests_per_sec() const;
+  double error_rate() const;
+
+private:
+  static constexpr char magic_[4] = {'R', 'B', 'B', 'L'};
+  static constexpr std::uint64_t format_version_ = 2;
+  static constexpr double significance_level_ = 0.05;
+  static constexpr std::size_t min_samples_ = 2; // Min. number of values (seconds) of a metric to test it
+
+  std::uint64_t runs_ = 0;
+  std::uint64_t requests_ = 0;
+  std::uint64_t errors_ = 0;
+  double duration_ms_ = 0;
+  Histogram latency_;
+  Histogram connect_;
+  Histogram handshake_;
+  // Values of every complete second
+  std::vector<double> throughput_; // Requests
+  std::vector<double> latency_avg_;
+  std::vector<double> latency_p50_;
+  std::vector<double> latency_p90_;
+  std::vector<double> latency_p99_;
+  std::vector<double> connect_p99_;
+  std::vector<double> handshake_p99_;
+
+  static void write_varint(std::ostream& out, std::uint64_t value);
+  static bool read_varint(std::istream& in, std::uint64_t& value);
+  static void write_double(std::ostream& out, double value);
+  static bool read_double(std::istream& in, double& value);
+  static void write_histogram(std::ostream& out, const Histogram& histogram);
+  static bool read_histogram(std::istream& in, Histogram& histogram);
+  static void write_samples(std::ostream& out, const std::vector<double>& samples);
+  static bool read_samples(std::istream& in, std::vector<double>& samples);
+
+  static double welch_t_test(const std::vector<double>& a, const std::vector<double>& b);
+  static double two_proportion_test(std::uint64_t successes_a, std::uint64_t total_a, std::uint64_t successes_b, std::uint64_t total_b);
+  static double incomplete_beta(double a, double b, double x);
+};
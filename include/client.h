@@ -1,12 +1,19 @@
 #pragma once
 
+#include <asio/awaitable.hpp>
 #include <asio/io_context.hpp>
 #include <asio/ip/basic_resolver.hpp>
 #include <asio/ip/tcp.hpp>
+#include <asio/local/stream_protocol.hpp>
 #include <asio/ssl.hpp>
 #include <asio/streambuf.hpp>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
+#include "connection_state.h"
+#include "mapped_file.h"
 #include "reply_struct.h"
 #include "result_response_struct.h"
 #include "settings_struct.h"
@@ -21,27 +28,58 @@ public:
   explicit Client(const Settings& settings, asio::io_context& io_context);
   virtual ~Client();
 
-  void do_request() const;
+  asio::awaitable<ResultResponse> do_request(ConnectionState& state) const;
 
 private:
+  static constexpr std::size_t body_file_chunk_size_ = 1024 * 1024; // Body file write size, without sendfile()
+
   std::string url_;
-  std::string post_data_;
+  std::string method_;
+  std::string host_header_; // Overrides the Host header, empty to use the host (and port) of the URL
   bool verbose_;
   bool silent_;
   bool verify_peer_;
   bool override_verify_tls_;
   bool debug_verify_tls_;
   long ssl_options_;
+  TestMode mode_;
+  bool tls_resume_;
+  std::chrono::milliseconds connect_timeout_;
+  std::chrono::milliseconds handshake_timeout_;
+  std::chrono::milliseconds first_byte_timeout_;
+  std::chrono::milliseconds total_timeout_;
   asio::io_context& io_context_;
+  std::unique_ptr<asio::ssl::context> tls_context_;
+  std::unique_ptr<MappedFile> body_file_; // Request body, mapped once (nullptr when not used)
 
   asio::ip::basic_resolver<asio::ip::tcp>::results_type resolve_result_;
+  asio::local::stream_protocol::endpoint unix_endpoint_; // Only used for Unix domain socket URLs (unix://)
   std::chrono::duration<double, std::milli> dns_lookup_duration_;
   std::string protocol_;
   std::string host_;
   std::string port_;
   std::string path_params_;
+  std::string request_; // The HTTP request is the same for every request, build once
+
+  // Response buffer allocating from the arena of the connection
+  using ResponseBuffer = asio::basic_streambuf<std::pmr::polymorphic_allocator<char>>;
 
+  std::string build_request(const std::string& post_data) const;
+  void create_tls_context(const Settings& settings);
+  static int connection_state_index();
+  static int new_session_callback(SSL* ssl, SSL_SESSION* session);
   bool verify_certificate_callback(bool preverified, asio::ssl::verify_context& context) const;
-  template <typename SyncReadStream> static ResultResponse handle_request(SyncReadStream& socket, asio::streambuf& request);
-  template <typename SyncReadStream> static Reply parse_response(SyncReadStream& socket);
+  static std::chrono::steady_clock::time_point
+  deadline(std::chrono::steady_clock::time_point start, std::chrono::milliseconds timeout, std::chrono::steady_clock::time_point max_deadline);
+  template <typename AsyncStream>
+  asio::awaitable<ResultResponse>
+  handle_request(AsyncStream& socket, ConnectionState& state, std::chrono::steady_clock::time_point total_deadline) const;
+  template <typename AsyncStream> asio::awaitable<std::size_t> write_body_file(AsyncStream& socket) const;
+#ifdef __linux__
+  template <typename Protocol, typename Executor>
+  asio::awaitable<std::size_t> write_body_file(asio::basic_stream_socket<Protocol, Executor>& socket) const;
+#endif
+  template <typename AsyncStream>
+  static asio::awaitable<Reply> parse_response(AsyncStream& socket, ConnectionState& state, std::chrono::steady_clock::time_point total_deadline);
+  static bool equals_ignore_case(std::string_view left, std::string_view right);
 };
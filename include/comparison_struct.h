@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ComparisonMetric
+{
+  std::string name;
+  std::string unit;
+  double baseline = 0;
+  double current = 0;
+  double change = 0;  // Relative change in percentage (current compared to baseline)
+  double p_value = 1; // Probability that the difference is caused by chance
+  bool higher_is_better = false;
+  bool significant = false;          // p-value is below the significance level
+  bool insufficient_samples = false; // Less than 2 values (seconds) in the baseline or the current run, the metric can not be tested
+  bool below_noise_floor = false;    // Absolute difference is below the noise floor (latency only)
+  bool regression = false;           // Significant, worse than the threshold and above the noise floor
+};
+
+struct Comparison
+{
+  std::uint64_t baseline_runs = 0;
+  double threshold = 0;   // Max. allowed regression in percentage
+  double noise_floor = 0; // Min. latency difference in ms before a latency metric can regress
+  std::vector<ComparisonMetric> metrics;
+  bool regression = false;           // At least one of the metrics regressed
+  bool insufficient_samples = false; // At least one of the metrics could not be tested, the comparison fails
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <asio/any_io_executor.hpp>
+#include <asio/steady_timer.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <openssl/ssl.h>
+
+/**
+ * \class ConnectionState
+ * \brief State of a single (virtual) connection, kept between its requests
+ * \details Holds the last TLS session (used for TLS session resumption), the timeout timer and the memory arena.
+ * On a timeout the watched socket is closed, which cancels all pending operations on the socket.
+ * Must be owned by a shared pointer (the timer handler only keeps a weak reference).
+ */
+class ConnectionState : public std::enable_shared_from_this<ConnectionState>
+{
+public:
+  explicit ConnectionState(const asio::any_io_executor& executor);
+  virtual ~ConnectionState();
+  ConnectionState(const ConnectionState&) = delete;
+  ConnectionState& operator=(const ConnectionState&) = delete;
+
+  /**
+   * \brief Last TLS session of this connection (nullptr if none)
+   */
+  SSL_SESSION* tls_session() const
+  {
+    return tls_session_;
+  }
+  void set_tls_session(SSL_SESSION* session);
+
+  /**
+   * \brief Set the socket to close on a timeout
+   * \param socket The (lowest layer) socket, must stay alive until finish_request() is called
+   */
+  template <typename Socket> void watch(Socket& socket)
+  {
+    socket_ = &socket;
+    close_socket_ = [](void* socket_ptr)
+    {
+      asio::error_code error;
+      static_cast<Socket*>(socket_ptr)->close(error);
+    };
+  }
+  void expires_at(std::chrono::steady_clock::time_point deadline);
+  void start_request();
+  void finish_request();
+
+  /**
+   * \brief True when the current request timed out
+   */
+  bool timed_out() const
+  {
+    return timed_out_;
+  }
+
+  /**
+   * \brief Memory arena for the request/response objects of the current request
+   */
+  std::pmr::memory_resource* arena()
+  {
+    return &arena_;
+  }
+
+private:
+  SSL_SESSION* tls_session_ = nullptr;
+  asio::steady_timer timer_;
+  unsigned int generation_ = 0; // Incremented each time the timer is set, ignores expired handlers of a previous deadline
+  bool timed_out_ = false;
+  void* socket_ = nullptr;
+  void (*close_socket_)(void*) = nullptr;
+  // Initial arena buffer, fits a typical API response (status line, headers and a small body) together with the parsed
+  // reply, so most requests never touch the pool. Larger responses use (re-used) memory of the pool.
+  static constexpr std::size_t arena_buffer_size_ = 16 * 1024;
+  // Largest block re-used by the pool, larger allocations (eg. large bodies) go straight to the heap
+  static constexpr std::size_t arena_pool_max_block_size_ = 1024 * 1024;
+  alignas(std::max_align_t) std::array<std::byte, arena_buffer_size_> arena_buffer_;
+  std::pmr::unsynchronized_pool_resource arena_pool_;
+  std::pmr::monotonic_buffer_resource arena_;
+
+  void expire();
+};
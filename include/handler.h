@@ -1,7 +1,17 @@
 #pragma once
 
+#include <asio/awaitable.hpp>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+#include "trial_result_struct.h"
+
 // Forward declaration
 class Settings;
+class Client;
+class Statistics;
+class Aggregator;
 
 /**
  * \class Handler
@@ -10,8 +20,27 @@ class Settings;
 class Handler
 {
 public:
-  static void start(const Settings& settings);
+  static int start(const Settings& settings);
 
 private:
   Handler() = delete;
+
+  static std::size_t number_of_threads(const Settings& settings);
+  static Statistics run(const Settings& settings,
+                        const Client& client,
+                        std::size_t concurrency,
+                        int requests,
+                        std::chrono::seconds duration,
+                        bool show_progress,
+                        std::ostream* raw_log,
+                        Statistics* warmup = nullptr);
+  static asio::awaitable<void> connection_loop(const Client& client,
+                                               Aggregator& aggregator,
+                                               std::size_t producer,
+                                               int warmup_requests,
+                                               std::chrono::steady_clock::time_point warmup_stop_time,
+                                               int requests,
+                                               std::chrono::seconds duration);
+  static void find_max(const Settings& settings, const Client& client);
+  static TrialResult run_trial(const Settings& settings, const Client& client, std::size_t concurrency);
 };
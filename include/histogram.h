@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+/**
+ * \class Histogram
+ * \brief Latency histogram using log-linear buckets (fixed size, ~1% precision)
+ * \details Values are stored in microseconds. Values below 128us get their own bucket,
+ * above that every power of two is divided into 64 sub-buckets.
+ */
+class Histogram
+{
+public:
+  void record(std::chrono::duration<double, std::milli> value);
+  void merge(const Histogram& other);
+  void reset();
+
+  std::uint64_t count() const
+  {
+    return count_;
+  }
+  double min() const;
+  double max() const;
+  double mean() const;
+  double percentile(double percentile) const;
+
+private:
+  friend class Baseline; // Stores and loads the buckets
+
+  static constexpr int sub_bucket_bits_ = 6;
+  static constexpr int max_value_bits_ = 37; // ~38 hours in microseconds
+  static constexpr std::size_t bucket_count_ = (max_value_bits_ - sub_bucket_bits_ + 1) << sub_bucket_bits_;
+
+  static std::size_t bucket_index(std::uint64_t value);
+  static double bucket_value(std::size_t index);
+
+  std::array<std::uint64_t, bucket_count_> buckets_{};
+  std::uint64_t count_ = 0;
+  std::uint64_t min_ = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t max_ = 0;
+  double sum_ = 0;
+};
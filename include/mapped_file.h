@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \class MappedFile
+ * \brief Read-only memory mapping of a whole file (eg. a large request body)
+ * \details The file is mapped once and shared by all connections. The file descriptor stays open, so the file
+ * can also be send using sendfile(). Without mmap() (non POSIX platforms), the file is read into a buffer instead.
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  virtual ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& path);
+  bool truncated() const;
+
+  const char* data() const
+  {
+    return static_cast<const char*>(data_);
+  }
+  std::size_t size() const
+  {
+    return size_;
+  }
+  // File descriptor, -1 without mmap() support
+  int native_handle() const
+  {
+    return fd_;
+  }
+
+private:
+  int fd_ = -1;
+  void* data_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<char> buffer_; // Only used without mmap() support
+
+  void close();
+};
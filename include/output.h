@@ -5,15 +5,26 @@
 #include <string>
 #include <vector>
 
+#include "comparison_struct.h"
+#include "settings_struct.h"
+#include "trial_result_struct.h"
+
 // Forward declaration
-class Settings;
+class Statistics;
+class Histogram;
 
 class Output
 {
 public:
   static void display_progress_bar(int percentage, int remaining_time = -1, int remaining_requests = -1);
   static void test_info(const std::size_t num_threads, const Settings& settings);
-  static void test_report(const Settings& settings, int total, std::chrono::duration<double, std::milli> total_test_duration);
+  static void test_report(const Settings& settings,
+                          const Statistics& statistics,
+                          const Statistics& warmup,
+                          std::chrono::duration<double, std::milli> total_test_duration);
+  static void trial_progress(const TrialResult& result);
+  static void find_max_report(const Settings& settings, const std::vector<TrialResult>& curve, const TrialResult* best);
+  static void comparison_report(const Comparison& comparison);
   static void print_table(const std::vector<std::vector<std::string>>& table, const std::string& header = "", const std::string& footer = "");
 
   template <typename T> static std::string to_string_with_precision(const T a_value, const int n = 2)
@@ -26,4 +37,8 @@ public:
 
 private:
   Output() = delete;
+
+  static std::string slo_description(const Settings& settings);
+  static std::string percentiles_description(const Histogram& histogram);
+  static std::string mode_name(TestMode mode);
 };
\ No newline at end of file
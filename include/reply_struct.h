@@ -1,13 +1,25 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+/**
+ * \brief HTTP reply, the memory is allocated from the arena of the connection (see ConnectionState)
+ */
 struct Reply
 {
-  std::string http_version;
-  unsigned int status_code;
-  std::string status_message;
-  std::vector<std::pair<std::string, std::string>> headers;
-  std::string body;
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+  Reply() = default;
+  explicit Reply(const allocator_type& allocator) : http_version(allocator), status_message(allocator), headers(allocator), body(allocator)
+  {
+  }
+
+  std::pmr::string http_version;
+  unsigned int status_code = 0;
+  std::pmr::string status_message;
+  std::pmr::vector<std::pair<std::pmr::string, std::pmr::string>> headers;
+  std::pmr::string body;
+  std::size_t size = 0; // Total received bytes (status line, headers and body)
 };
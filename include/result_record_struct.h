@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include "result_response_struct.h"
+
+/**
+ * \brief Compact fixed-size result of a single request, passed from the workers to the aggregator
+ * \details All durations are in microseconds.
+ */
+struct ResultRecord
+{
+  std::uint32_t timestamp; // Completion time in ms since the start of the measurement (or the run for warm-up results)
+  std::uint32_t bytes;     // Received bytes (status line, headers and body)
+  std::uint32_t sent;      // Sent bytes (request and body)
+  std::uint32_t prepare_request;
+  std::uint32_t connect;
+  std::uint32_t handshake;
+  std::uint32_t request;
+  std::uint32_t response;
+  std::uint32_t total; // Total without DNS
+  std::uint16_t status_code;
+  std::uint16_t endpoint; // Index of the URL under test
+  ResultStatus status;
+  bool tls_resumed;
+  bool warmup;  // Result of the warm-up, excluded from the statistics
+  bool message; // A message (error or verbose response) is pushed to the message ring buffer of the producer
+};
@@ -1,10 +1,31 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
 #include "duration_struct.h"
 #include "reply_struct.h"
 
+enum class ResultStatus : std::uint8_t
+{
+  Success,
+  Error,
+  Timeout
+};
+
 struct ResultResponse
 {
+  ResultResponse() = default;
+  explicit ResultResponse(const Reply::allocator_type& allocator) : reply(allocator), error(allocator)
+  {
+  }
+
+  ResultStatus status = ResultStatus::Success;
+  bool tls_resumed = false; // TLS session was resumed during the handshake
+  std::size_t sent = 0;     // Sent bytes (request and body)
   Reply reply;
   Duration duration;
+  std::pmr::string error; // Error message of a failed request, printed by the aggregator (empty when silent)
 };
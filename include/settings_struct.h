@@ -1,19 +1,61 @@
 #pragma once
 
 #include <string>
+#include <vector>
+
+enum class TestMode
+{
+  Http,      // Full HTTP requests
+  Connect,   // Only open (and close) TCP connections
+  Handshake, // Only open TCP connections and perform the TLS handshake
+};
 
 struct Settings
 {
   int threads;
   int requests;
   int duration_sec;
+  int warmup_requests; // Warm-up requests before the measurement (excluded from the results)
+  int warmup_sec;      // Warm-up duration, used instead of the warm-up requests when set
+  bool async;      // Use the async engine (multiplex the connections on the threads)
+  int connections; // Number of concurrent connections (async engine only)
+  TestMode mode;
 
-  std::string url; // TODO: Support multiple URLs as a vector
+  std::string url;    // TODO: Support multiple URLs as a vector
+  std::string method; // HTTP method (GET, POST, PUT, PATCH or DELETE)
+  std::string host;   // Host header, empty to use the host of the URL (localhost for Unix domain sockets)
   std::string post_data;
+  std::string body_file; // Send the content of this file as request body, empty to disable
   bool verify_peer;
   bool override_verify_tls;
   bool verbose;
   bool silent;
   bool debug;
   long ssl_options;
+  std::string tls_version;  // "1.2" or "1.3"
+  std::string ciphers;      // TLS v1.2 cipher list (OpenSSL format), empty for default
+  std::string ciphersuites; // TLS v1.3 cipher suites (OpenSSL format), empty for default
+  std::string curves;       // ECDHE curves / groups (eg. X25519:P-256), empty for default
+  bool tls_resume;          // Resume the TLS session of the previous request of the same connection
+  std::string raw_log_file; // Log every result (CSV), empty to disable
+
+  // Timeouts in ms, zero to disable
+  int connect_timeout_ms;
+  int handshake_timeout_ms;
+  int first_byte_timeout_ms;
+  int total_timeout_ms;
+
+  // Find max. throughput under a latency SLO
+  bool find_max;
+  double slo_latency_ms;
+  double slo_percentile;
+  double slo_error_rate;
+  int trial_duration_sec;
+  int max_concurrency;
+
+  // Baseline comparison
+  std::string save_baseline_file;         // Save the results to a baseline file, empty to disable
+  std::vector<std::string> compare_files; // Compare the results with these baseline files (merged)
+  double regression_threshold;            // Max. allowed regression in percentage
+  double regression_noise_floor;          // Min. latency difference in ms before a latency metric can regress
 };
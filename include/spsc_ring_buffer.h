@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * \class SpscRingBuffer
+ * \brief Lock-free single-producer/single-consumer ring buffer with a fixed capacity
+ * \details Only one thread may call try_push() and only one (other) thread may call try_pop().
+ * Producer and consumer indices live on separate cache lines to avoid false sharing.
+ */
+template <typename T, std::size_t Capacity> class SpscRingBuffer
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  /**
+   * \brief Add an item (producer side)
+   * \return False when the buffer is full
+   */
+  bool try_push(const T& item)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_cache_ == Capacity)
+    {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head - tail_cache_ == Capacity)
+        return false;
+    }
+    buffer_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief Remove the oldest item (consumer side)
+   * \return False when the buffer is empty
+   */
+  bool try_pop(T& item)
+  {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_cache_)
+    {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail == head_cache_)
+        return false;
+    }
+    item = buffer_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::size_t cache_line_size_ = 64;
+
+  // Producer side
+  alignas(cache_line_size_) std::atomic<std::size_t> head_ = 0;
+  std::size_t tail_cache_ = 0;
+  // Consumer side
+  alignas(cache_line_size_) std::atomic<std::size_t> tail_ = 0;
+  std::size_t head_cache_ = 0;
+
+  alignas(cache_line_size_) std::array<T, Capacity> buffer_;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "histogram.h"
+#include "result_record_struct.h"
+#include "time_series_point_struct.h"
+
+/**
+ * \class Statistics
+ * \brief Collected results of a test run (not thread-safe, only the aggregator records results)
+ */
+class Statistics
+{
+public:
+  Statistics();
+
+  void record(const ResultRecord& record);
+  void finish();
+
+  std::uint64_t requests() const
+  {
+    return requests_;
+  }
+  std::uint64_t errors() const
+  {
+    return errors_;
+  }
+  std::uint64_t timeouts() const
+  {
+    return timeouts_;
+  }
+  std::uint64_t bytes() const
+  {
+    return bytes_;
+  }
+  std::uint64_t bytes_sent() const
+  {
+    return bytes_sent_;
+  }
+  double error_rate() const;
+  std::uint64_t handshakes() const
+  {
+    return handshakes_;
+  }
+  std::uint64_t tls_resumed() const
+  {
+    return tls_resumed_;
+  }
+  const Histogram& latency() const
+  {
+    return latency_;
+  }
+  const Histogram& connect() const
+  {
+    return connect_;
+  }
+  const Histogram& handshake() const
+  {
+    return handshake_;
+  }
+  const std::vector<TimeSeriesPoint>& time_series() const
+  {
+    return time_series_;
+  }
+  std::chrono::duration<double, std::milli> duration() const
+  {
+    return duration_;
+  }
+  void set_duration(std::chrono::duration<double, std::milli> duration)
+  {
+    duration_ = duration;
+  }
+  std::uint64_t allocations() const
+  {
+    return allocations_;
+  }
+  void add_allocations(std::uint64_t allocations)
+  {
+    allocations_ += allocations;
+  }
+
+private:
+  // Results arrive slightly out of order (one ring buffer per worker), the histograms of the last seconds are kept open
+  static constexpr std::size_t open_seconds_ = 4;
+  static constexpr std::size_t no_second_ = std::numeric_limits<std::size_t>::max();
+
+  Histogram latency_;
+  Histogram connect_;
+  Histogram handshake_;
+  std::vector<TimeSeriesPoint> time_series_; // One point per second
+  std::uint64_t requests_ = 0;
+  std::uint64_t errors_ = 0;   // All failed requests, including timeouts
+  std::uint64_t timeouts_ = 0; // Requests cancelled due to a timeout
+  std::uint64_t bytes_ = 0;      // Received bytes of the requests that got a response
+  std::uint64_t bytes_sent_ = 0; // Request bytes of the requests that got a response
+  std::uint64_t handshakes_ = 0;  // Successful TLS handshakes
+  std::uint64_t tls_resumed_ = 0; // TLS handshakes that resumed a session
+  std::uint64_t allocations_ = 0; // Heap allocations of the workers (see AllocationCounter)
+  std::chrono::duration<double, std::milli> duration_{}; // Duration of the measurement
+  // Histograms of the open seconds, used for the per-second percentiles of the time series
+  std::array<std::size_t, open_seconds_> open_second_;
+  std::array<Histogram, open_seconds_> second_latency_;
+  std::array<Histogram, open_seconds_> second_connect_;
+  std::array<Histogram, open_seconds_> second_handshake_;
+
+  std::size_t open_slot(std::size_t second);
+  void close_slot(std::size_t slot);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * \brief Results within a single second of the test run
+ */
+struct TimeSeriesPoint
+{
+  std::uint64_t requests;
+  std::uint64_t errors;
+  std::uint64_t responses;  // Requests that got a response (part of the latency)
+  double latency_sum;       // Sum of the latencies in ms (divide by responses for the average)
+  double latency_max;       // Highest latency in ms
+  std::uint64_t handshakes; // TLS handshakes (part of the handshake percentile)
+  // Percentiles in ms within this second, only set when the second is complete (see Statistics::finish())
+  double latency_p50;
+  double latency_p90;
+  double latency_p99;
+  double connect_p99;
+  double handshake_p99;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * \brief Measured result of a single find max. throughput trial
+ */
+struct TrialResult
+{
+  std::size_t concurrency;
+  double requests_per_sec; // Successful requests per second
+  double latency;          // Latency in ms at the SLO percentile
+  double error_rate;       // Percentage of failed requests
+  bool passed;
+};
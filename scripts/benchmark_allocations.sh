@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# By: Melroy van den Berg
+# Description: Count the heap allocations per request, fails when the number exceeds the maximum.
+#   Used to make sure the request path stays (nearly) allocation free.
+# Usage: ./scripts/benchmark_allocations.sh <URL> [max. allocations per request] [duration in seconds]
+set -e
+
+URL=${1:?"Usage: $0 <URL> [max. allocations per request] [duration]"}
+MAX_ALLOCATIONS=${2:-12}
+DURATION=${3:-5}
+
+echo "INFO: Building with allocation counter..."
+cmake -GNinja -DCMAKE_BUILD_TYPE=Release -DCOUNT_ALLOCATIONS=ON -B build_allocations > /dev/null
+cmake --build ./build_allocations --target rambam --config Release > /dev/null
+
+failed=0
+for args in "-t 1" "--async -t 2 -c 32"; do
+  # shellcheck disable=SC2086
+  allocations=$(./build_allocations/rambam ${args} -d "${DURATION}" "${URL}" | grep "Heap allocations/request:" | awk -F'|' '{gsub(/[^0-9.]/, "", $2); print $2}')
+  printf "%-22s %10s allocations/request\n" "${args}" "${allocations}"
+  if awk -v value="${allocations}" -v max="${MAX_ALLOCATIONS}" 'BEGIN { exit !(value > max) }'; then
+    failed=1
+  fi
+done
+
+if [ "${failed}" -ne 0 ]; then
+  echo "ERROR: More than ${MAX_ALLOCATIONS} heap allocations per request."
+  exit 1
+fi
@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+# By: Melroy van den Berg
+# Description: Compare the epoll and io_uring backends of the async engine on the same workload.
+#   Sweeps the number of connections to find the max. reqs/sec of each backend. At the connections of the max.,
+#   the syscalls and CPU time per request are measured for the worker threads only (requires perf).
+# Usage: ./scripts/benchmark_io_uring.sh <URL> [duration in seconds] [connections to sweep] [threads]
+set -e
+
+URL=${1:?"Usage: $0 <URL> [duration] [connections to sweep] [threads]"}
+DURATION=${2:-10}
+CONNECTIONS=${3:-"16 32 64 128 256 512"}
+THREADS=${4:-4}
+# CPU time per task-clock sample in ns (perf record -c), used to estimate the CPU time of the worker threads
+CPU_SAMPLE_NS=100000
+
+build() {
+  local folder=$1
+  local io_uring=$2
+  cmake -GNinja -DCMAKE_BUILD_TYPE=Release -DIO_URING="${io_uring}" -B "${folder}" > /dev/null
+  cmake --build "./${folder}" --target rambam --config Release > /dev/null
+}
+
+# Run a single test, print the total requests and the reqs/sec
+run() {
+  local binary=$1
+  local connections=$2
+  local rambam_output
+  rambam_output=$(mktemp)
+
+  "${binary}" --async -t "${THREADS}" -c "${connections}" -d "${DURATION}" "${URL}" > "${rambam_output}"
+  local requests
+  local reqs_per_sec
+  requests=$(grep "Total requests executed:" "${rambam_output}" | awk -F'|' '{gsub(/[^0-9]/, "", $2); print $2}')
+  reqs_per_sec=$(grep "Average reqs/sec:" "${rambam_output}" | awk -F'|' '{gsub(/[^0-9.]/, "", $2); print $2}')
+  rm -f "${rambam_output}"
+  echo "${requests} ${reqs_per_sec}"
+}
+
+benchmark() {
+  local name=$1
+  local binary=$2
+
+  # Max. reqs/sec, without perf (the recording would lower the throughput)
+  local best_connections=0
+  local best_reqs_per_sec=0
+  local connections
+  for connections in ${CONNECTIONS}; do
+    local result
+    result=$(run "${binary}" "${connections}")
+    echo "INFO: ${name} with ${connections} connections: $(echo "${result}" | cut -d' ' -f2) reqs/sec" >&2
+    if awk -v a="$(echo "${result}" | cut -d' ' -f2)" -v b="${best_reqs_per_sec}" 'BEGIN { exit !(a > b) }'; then
+      best_connections=${connections}
+      best_reqs_per_sec=$(echo "${result}" | cut -d' ' -f2)
+    fi
+  done
+
+  # Syscalls and CPU time of the worker threads only, the main thread (progress poll) and
+  # the aggregator thread (drain loop) are a constant load that would dilute the difference.
+  local perf_data
+  local rambam_output
+  perf_data=$(mktemp)
+  rambam_output=$(mktemp)
+  perf record -q -o "${perf_data}" -e raw_syscalls:sys_enter -e task-clock -c "${CPU_SAMPLE_NS}" -- \
+    "${binary}" --async -t "${THREADS}" -c "${best_connections}" -d "${DURATION}" "${URL}" > "${rambam_output}"
+  local requests
+  requests=$(grep "Total requests executed:" "${rambam_output}" | awk -F'|' '{gsub(/[^0-9]/, "", $2); print $2}')
+  perf script -i "${perf_data}" -F comm,event 2> /dev/null | awk -v name="${name}" -v connections="${best_connections}" \
+    -v requests="${requests}" -v rps="${best_reqs_per_sec}" -v sample_ns="${CPU_SAMPLE_NS}" '
+      $1 == "rambam-worker" && /raw_syscalls:sys_enter/ { syscalls++ }
+      $1 == "rambam-worker" && /task-clock/ { cpu_samples++ }
+      END { printf "%-10s %12d %14.2f %18.2f %20.2f\n", name, connections, rps, syscalls / requests, cpu_samples * sample_ns / 1000 / requests }'
+  rm -f "${perf_data}" "${rambam_output}"
+}
+
+echo "INFO: Building epoll & io_uring variants..."
+build build_epoll OFF
+build build_io_uring ON
+
+results=$(benchmark "epoll" ./build_epoll/rambam; benchmark "io_uring" ./build_io_uring/rambam)
+printf "%-10s %12s %14s %18s %20s\n" "Backend" "Connections" "Max. reqs/sec" "Syscalls/request" "CPU us/request"
+echo "${results}"
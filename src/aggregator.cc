@@ -0,0 +1,279 @@
+#include "aggregator.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "allocation_counter.h"
+#include "output.h"
+
+/**
+ * \brief Aggregator constructor
+ * \param producers Number of workers pushing results
+ * \param verbose Print every result
+ * \param raw_log Optional stream to write every result to (CSV), nullptr to disable
+ */
+Aggregator::Aggregator(std::size_t producers, bool verbose, std::ostream* raw_log)
+    : verbose_(verbose),
+      raw_log_(raw_log),
+      start_time_point_(std::chrono::steady_clock::now())
+{
+  rings_.reserve(producers);
+  message_rings_.reserve(producers);
+  for (std::size_t i = 0; i < producers; ++i)
+  {
+    rings_.push_back(std::make_unique<Ring>());
+    message_rings_.push_back(std::make_unique<MessageRing>());
+  }
+}
+
+/**
+ * \brief Destructor, stops the aggregator thread if still running
+ */
+Aggregator::~Aggregator()
+{
+  stop();
+}
+
+/**
+ * \brief Start the aggregator thread, also the start of the run
+ * \param warmup_connections Number of connections doing a warm-up, zero to start the measurement immediately
+ */
+void Aggregator::start(std::size_t warmup_connections)
+{
+  start_time_point_ = std::chrono::steady_clock::now();
+  measurement_start_.store(start_time_point_.time_since_epoch().count(), std::memory_order_relaxed);
+  measurement_end_.store(0, std::memory_order_relaxed);
+  measurement_allocations_.store(AllocationCounter::count(), std::memory_order_relaxed);
+  warmup_connections_.store(warmup_connections, std::memory_order_relaxed);
+  measuring_.store(warmup_connections == 0, std::memory_order_release);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&Aggregator::run, this);
+}
+
+/**
+ * \brief Stop the aggregator thread, after processing all remaining results
+ * \details The duration of the statistics is counted from the start of the measurement until the last connection finished,
+ * the heap allocations until the stop.
+ */
+void Aggregator::stop()
+{
+  running_.store(false, std::memory_order_release);
+  if (thread_.joinable())
+  {
+    thread_.join();
+    statistics_.finish();
+    warmup_statistics_.finish();
+    const auto end = measurement_end_.load(std::memory_order_relaxed);
+    const auto end_time_point =
+        (end == 0) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(end));
+    statistics_.set_duration(end_time_point - measurement_start());
+    statistics_.add_allocations(AllocationCounter::count() - measurement_allocations_.load(std::memory_order_relaxed));
+  }
+}
+
+/**
+ * \brief Called by each connection after its warm-up, the last connection starts the measurement
+ * \details Timestamps of the measured results are relative to the start of the measurement.
+ * The heap allocations of the warm-up are excluded, the allocation count restarts with the measurement.
+ */
+void Aggregator::finish_warmup()
+{
+  if (warmup_connections_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    measurement_start_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    measurement_allocations_.store(AllocationCounter::count(), std::memory_order_relaxed);
+    measuring_.store(true, std::memory_order_release);
+  }
+}
+
+/**
+ * \brief Called by each connection after its last measured request, the last connection ends the measurement
+ * \details Not counted like the warm-up, the latest timestamp wins. So the duration does not depend on when the
+ * main thread notices that all threads are finished.
+ */
+void Aggregator::finish_connection()
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto end = measurement_end_.load(std::memory_order_relaxed);
+  while (end < now && !measurement_end_.compare_exchange_weak(end, now, std::memory_order_relaxed))
+  {
+  }
+}
+
+/**
+ * \brief Push the result of a request (worker side, never blocks on a lock)
+ * \param producer Index of the worker, each worker must use its own index
+ * \param result The result of the request
+ * \param warmup Result of the warm-up
+ */
+void Aggregator::push(std::size_t producer, const ResultResponse& result, bool warmup)
+{
+  auto to_us = [](std::chrono::duration<double, std::milli> duration)
+  { return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count()); };
+
+  ResultRecord record;
+  const auto start_time_point = warmup ? start_time_point_ : measurement_start();
+  record.timestamp =
+      static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time_point).count());
+  record.bytes = static_cast<std::uint32_t>(result.reply.size);
+  record.sent = static_cast<std::uint32_t>(std::min<std::size_t>(result.sent, std::numeric_limits<std::uint32_t>::max()));
+  record.prepare_request = to_us(result.duration.prepare_request);
+  record.connect = to_us(result.duration.connect);
+  record.handshake = to_us(result.duration.handshake);
+  record.request = to_us(result.duration.request);
+  record.response = to_us(result.duration.response);
+  record.total = to_us(result.duration.total_without_dns);
+  record.status_code = static_cast<std::uint16_t>(result.reply.status_code);
+  record.endpoint = 0; // Only a single URL is supported for now
+  record.status = result.status;
+  record.tls_resumed = result.tls_resumed;
+  record.warmup = warmup;
+  record.message = false;
+
+  std::string message;
+  if (!result.error.empty())
+    message.assign(result.error);
+  else if (verbose_ && !warmup && result.status == ResultStatus::Success)
+    message = Aggregator::verbose_response(result.reply);
+  if (!message.empty())
+  {
+    // The message is pushed before the record, the aggregator pops it when processing the record
+    record.message = true;
+    MessageRing& message_ring = *message_rings_[producer];
+    while (!message_ring.try_push(message))
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  // Back-pressure: wait for the aggregator when the ring buffer is full, results are never dropped
+  Ring& ring = *rings_[producer];
+  while (!ring.try_push(record))
+  {
+    std::this_thread::yield();
+  }
+}
+
+/**
+ * \brief Aggregator thread main loop
+ */
+void Aggregator::run()
+{
+  while (running_.load(std::memory_order_acquire))
+  {
+    if (drain() == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Process the results pushed just before stopping
+  while (drain() > 0)
+  {
+  }
+}
+
+/**
+ * \brief Drain all ring buffers
+ * \return Number of processed results
+ */
+std::size_t Aggregator::drain()
+{
+  std::size_t count = 0;
+  std::size_t measured = 0;
+  ResultRecord record;
+  std::string message;
+  for (std::size_t producer = 0; producer < rings_.size(); ++producer)
+  {
+    while (rings_[producer]->try_pop(record))
+    {
+      message.clear();
+      if (record.message)
+        message_rings_[producer]->try_pop(message);
+      process(record, message);
+      ++count;
+      if (!record.warmup)
+        ++measured;
+    }
+  }
+  processed_.fetch_add(measured, std::memory_order_relaxed);
+  return count;
+}
+
+/**
+ * \brief Get the name of a result status (as used in the raw log)
+ */
+const char* Aggregator::status_name(ResultStatus status)
+{
+  switch (status)
+  {
+  case ResultStatus::Success:
+    return "ok";
+  case ResultStatus::Timeout:
+    return "timeout";
+  default:
+    return "error";
+  }
+}
+
+/**
+ * \brief Format the status line, body and headers of a response (verbose output)
+ * \param reply The reply
+ */
+std::string Aggregator::verbose_response(const Reply& reply)
+{
+  std::string message = "Status: ";
+  message.append(reply.http_version).append(" ").append(std::to_string(reply.status_code)).append(" ").append(reply.status_message);
+  message.append("\nBody Content:\n").append(reply.body).append("\nHeaders:\n");
+  for (const auto& header : reply.headers)
+  {
+    message.append("Name: ").append(header.first).append(" Value: ").append(header.second).append("\n");
+  }
+  message.append("------------------------------------------------------");
+  return message;
+}
+
+/**
+ * \brief Process a single result
+ * \param record The result record
+ * \param message Error message or verbose response of the result, empty if none
+ */
+void Aggregator::process(const ResultRecord& record, const std::string& message)
+{
+  if (record.status != ResultStatus::Success && !message.empty())
+  {
+    std::cerr << "Error: " << message << std::endl;
+  }
+  if (record.warmup)
+  {
+    warmup_statistics_.record(record);
+    return;
+  }
+  statistics_.record(record);
+
+  if (raw_log_ != nullptr)
+  {
+    *raw_log_ << record.timestamp << ',' << record.endpoint << ',' << Aggregator::status_name(record.status) << ',' << record.status_code << ','
+              << record.bytes << ',' << record.sent << ',' << (record.tls_resumed ? 1 : 0) << ',' << record.prepare_request << ',' << record.connect
+              << ',' << record.handshake << ',' << record.request << ',' << record.response << ',' << record.total << '\n';
+  }
+
+  if (verbose_)
+  {
+    if (record.status == ResultStatus::Success)
+    {
+      std::cout << "Response: " << record.status_code << " (" << record.bytes << " bytes)" << std::endl;
+      std::cout << "Total duration: " << Output::to_string_with_precision(record.total / 1000.0, 3)
+                << "ms (prepare: " << Output::to_string_with_precision(record.prepare_request / 1000.0, 3)
+                << "ms, socket connect: " << Output::to_string_with_precision(record.connect / 1000.0, 3)
+                << "ms, handshake: " << Output::to_string_with_precision(record.handshake / 1000.0, 3)
+                << "ms, request: " << Output::to_string_with_precision(record.request / 1000.0, 3)
+                << "ms, response: " << Output::to_string_with_precision(record.response / 1000.0, 3) << "ms)" << std::endl;
+      if (!message.empty())
+        std::cout << message << std::endl;
+    }
+    else
+    {
+      std::cout << "Request " << Aggregator::status_name(record.status) << " after " << Output::to_string_with_precision(record.total / 1000.0, 3)
+                << "ms" << std::endl;
+    }
+  }
+}
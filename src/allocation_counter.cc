@@ -0,0 +1,92 @@
+#include "allocation_counter.h"
+
+#ifdef COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  std::atomic<std::uint64_t> allocations = 0;
+  thread_local bool track_thread = false;
+
+  void* allocate(std::size_t size, std::size_t alignment)
+  {
+    if (track_thread)
+      allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+      size = 1;
+    // Aligned alloc requires the size to be a multiple of the alignment
+    void* ptr = (alignment > alignof(std::max_align_t)) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                                                        : std::malloc(size);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+    return ptr;
+  }
+}
+
+void* operator new(std::size_t size)
+{
+  return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+#endif
+
+/**
+ * \brief True when the allocation counter is compiled in (COUNT_ALLOCATIONS option)
+ */
+bool AllocationCounter::enabled()
+{
+#ifdef COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * \brief Count the allocations of the calling thread from now on
+ */
+void AllocationCounter::track_current_thread()
+{
+#ifdef COUNT_ALLOCATIONS
+  track_thread = true;
+#endif
+}
+
+/**
+ * \brief Number of allocations of all tracked threads so far, zero when disabled
+ */
+std::uint64_t AllocationCounter::count()
+{
+#ifdef COUNT_ALLOCATIONS
+  return allocations.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
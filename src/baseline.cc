@@ -0,0 +1,466 @@
+#include "baseline.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "statistics.h"
+
+/**
+ * \brief Create a baseline of a single test run
+ * \param statistics The statistics of the run
+ * \param duration Total duration of the run
+ */
+Baseline::Baseline(const Statistics& statistics, std::chrono::duration<double, std::milli> duration)
+    : runs_(1),
+      requests_(statistics.requests()),
+      errors_(statistics.errors()),
+      duration_ms_(duration.count()),
+      latency_(statistics.latency()),
+      connect_(statistics.connect()),
+      handshake_(statistics.handshake())
+{
+  // The last second is incomplete, it would lower the throughput samples
+  const auto& time_series = statistics.time_series();
+  for (std::size_t second = 0; second + 1 < time_series.size(); ++second)
+  {
+    const TimeSeriesPoint& point = time_series[second];
+    throughput_.push_back(static_cast<double>(point.requests));
+    // Seconds without responses have no latency
+    if (point.responses > 0)
+    {
+      latency_avg_.push_back(point.latency_sum / point.responses);
+      latency_p50_.push_back(point.latency_p50);
+      latency_p90_.push_back(point.latency_p90);
+      latency_p99_.push_back(point.latency_p99);
+      connect_p99_.push_back(point.connect_p99);
+    }
+    if (point.handshakes > 0)
+      handshake_p99_.push_back(point.handshake_p99);
+  }
+}
+
+/**
+ * \brief Save the baseline to a binary file
+ * \param file Path of the file
+ * \return False when the file could not be written
+ */
+bool Baseline::save(const std::string& file) const
+{
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+
+  out.write(magic_, sizeof(magic_));
+  write_varint(out, format_version_);
+  write_varint(out, runs_);
+  write_varint(out, requests_);
+  write_varint(out, errors_);
+  write_double(out, duration_ms_);
+  write_histogram(out, latency_);
+  write_histogram(out, connect_);
+  write_histogram(out, handshake_);
+  write_samples(out, throughput_);
+  write_samples(out, latency_avg_);
+  write_samples(out, latency_p50_);
+  write_samples(out, latency_p90_);
+  write_samples(out, latency_p99_);
+  write_samples(out, connect_p99_);
+  write_samples(out, handshake_p99_);
+  return static_cast<bool>(out.flush());
+}
+
+/**
+ * \brief Load the baseline from a binary file, replacing the current content
+ * \param file Path of the file
+ * \return False when the file could not be read or is not a (supported) baseline file
+ */
+bool Baseline::load(const std::string& file)
+{
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    return false;
+
+  // Parse from memory, a baseline file is only a few KB
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+
+  char magic[sizeof(magic_)];
+  std::uint64_t version = 0;
+  if (!buffer.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(magic_)) || !read_varint(buffer, version) ||
+      version != format_version_)
+    return false;
+
+  Baseline baseline;
+  if (!read_varint(buffer, baseline.runs_) || !read_varint(buffer, baseline.requests_) || !read_varint(buffer, baseline.errors_) ||
+      !read_double(buffer, baseline.duration_ms_) || !read_histogram(buffer, baseline.latency_) || !read_histogram(buffer, baseline.connect_) ||
+      !read_histogram(buffer, baseline.handshake_))
+    return false;
+  if (!read_samples(buffer, baseline.throughput_) || !read_samples(buffer, baseline.latency_avg_) || !read_samples(buffer, baseline.latency_p50_) ||
+      !read_samples(buffer, baseline.latency_p90_) || !read_samples(buffer, baseline.latency_p99_) || !read_samples(buffer, baseline.connect_p99_) ||
+      !read_samples(buffer, baseline.handshake_p99_))
+    return false;
+
+  *this = std::move(baseline);
+  return true;
+}
+
+/**
+ * \brief Add the runs of another baseline
+ * \param other The other baseline
+ */
+void Baseline::merge(const Baseline& other)
+{
+  runs_ += other.runs_;
+  requests_ += other.requests_;
+  errors_ += other.errors_;
+  duration_ms_ += other.duration_ms_;
+  latency_.merge(other.latency_);
+  connect_.merge(other.connect_);
+  handshake_.merge(other.handshake_);
+  auto append = [](std::vector<double>& samples, const std::vector<double>& other_samples)
+  { samples.insert(samples.end(), other_samples.begin(), other_samples.end()); };
+  append(throughput_, other.throughput_);
+  append(latency_avg_, other.latency_avg_);
+  append(latency_p50_, other.latency_p50_);
+  append(latency_p90_, other.latency_p90_);
+  append(latency_p99_, other.latency_p99_);
+  append(connect_p99_, other.connect_p99_);
+  append(handshake_p99_, other.handshake_p99_);
+}
+
+/**
+ * \brief Compare the current run against this baseline
+ * \param current The baseline of the current run
+ * \param threshold Max. allowed regression in percentage
+ * \param noise_floor Min. latency difference in ms before a latency metric can regress
+ * \return The comparison of each metric, a metric regressed when the difference is significant, worse than the threshold
+ * and (for latency) larger than the noise floor. A metric with too few values (seconds) is marked as insufficient samples.
+ * \details The shown values are of the whole runs, the p-value of each metric is of its own test on the values of every second.
+ */
+Comparison Baseline::compare(const Baseline& current, double threshold, double noise_floor) const
+{
+  Comparison comparison;
+  comparison.baseline_runs = runs_;
+  comparison.threshold = threshold;
+  comparison.noise_floor = noise_floor;
+
+  auto add = [&](const std::string& name, const std::string& unit, double baseline, double value, double p_value, bool higher_is_better, double floor)
+  {
+    ComparisonMetric metric;
+    metric.name = name;
+    metric.unit = unit;
+    metric.baseline = baseline;
+    metric.current = value;
+    if (baseline != 0)
+      metric.change = (value - baseline) / baseline * 100.0;
+    else if (value != 0)
+      metric.change = std::numeric_limits<double>::infinity();
+    metric.p_value = p_value;
+    metric.higher_is_better = higher_is_better;
+    metric.significant = p_value < significance_level_;
+    metric.below_noise_floor = std::abs(value - baseline) < floor;
+    const double worse = higher_is_better ? -metric.change : metric.change;
+    metric.regression = metric.significant && worse > threshold && !metric.below_noise_floor;
+    comparison.regression = comparison.regression || metric.regression;
+    comparison.metrics.push_back(metric);
+  };
+  // Metrics tested on the values of every second, without enough values a regression can not be detected (never a silent pass)
+  auto add_tested = [&](const std::string& name,
+                        const std::string& unit,
+                        double baseline,
+                        double value,
+                        const std::vector<double>& samples,
+                        const std::vector<double>& current_samples,
+                        bool higher_is_better,
+                        double floor)
+  {
+    add(name, unit, baseline, value, welch_t_test(samples, current_samples), higher_is_better, floor);
+    if (samples.size() < min_samples_ || current_samples.size() < min_samples_)
+    {
+      comparison.metrics.back().insufficient_samples = true;
+      comparison.insufficient_samples = true;
+    }
+  };
+
+  add_tested("Throughput", "reqs/sec", requests_per_sec(), current.requests_per_sec(), throughput_, current.throughput_, true, 0);
+  const double error_rate_p_value = two_proportion_test(errors_, requests_, current.errors_, current.requests_);
+  add("Error rate", "%", error_rate() * 100.0, current.error_rate() * 100.0, error_rate_p_value, false, 0);
+
+  add_tested("Latency avg", "ms", latency_.mean(), current.latency_.mean(), latency_avg_, current.latency_avg_, false, noise_floor);
+  add_tested("Latency p50", "ms", latency_.percentile(50), current.latency_.percentile(50), latency_p50_, current.latency_p50_, false, noise_floor);
+  add_tested("Latency p90", "ms", latency_.percentile(90), current.latency_.percentile(90), latency_p90_, current.latency_p90_, false, noise_floor);
+  add_tested("Latency p99", "ms", latency_.percentile(99), current.latency_.percentile(99), latency_p99_, current.latency_p99_, false, noise_floor);
+  if (connect_.count() > 0 && current.connect_.count() > 0)
+  {
+    add_tested("Connect p99", "ms", connect_.percentile(99), current.connect_.percentile(99), connect_p99_, current.connect_p99_, false, noise_floor);
+  }
+  if (handshake_.count() > 0 && current.handshake_.count() > 0)
+  {
+    const double handshake_p99 = handshake_.percentile(99);
+    add_tested("Handshake p99", "ms", handshake_p99, current.handshake_.percentile(99), handshake_p99_, current.handshake_p99_, false, noise_floor);
+  }
+  return comparison;
+}
+
+/**
+ * \brief Average requests per second of all runs
+ */
+double Baseline::requests_per_sec() const
+{
+  return (duration_ms_ <= 0) ? 0.0 : requests_ / (duration_ms_ / 1000.0);
+}
+
+/**
+ * \brief Ratio of failed requests (between 0.0 and 1.0)
+ */
+double Baseline::error_rate() const
+{
+  return (requests_ == 0) ? 0.0 : static_cast<double>(errors_) / requests_;
+}
+
+/**
+ * \brief Write an unsigned integer using 7 bits per byte (LEB128), small values only take a single byte
+ */
+void Baseline::write_varint(std::ostream& out, std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.put(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+/**
+ * \brief Read an unsigned integer written by write_varint()
+ * \return False on a read error or a malformed value
+ */
+bool Baseline::read_varint(std::istream& in, std::uint64_t& value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    const int byte = in.get();
+    if (byte == std::char_traits<char>::eof())
+      return false;
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * \brief Write a double as 8 bytes (little endian)
+ */
+void Baseline::write_double(std::ostream& out, double value)
+{
+  const auto bits = std::bit_cast<std::uint64_t>(value);
+  for (int i = 0; i < 8; ++i)
+  {
+    out.put(static_cast<char>((bits >> (i * 8)) & 0xff));
+  }
+}
+
+/**
+ * \brief Read a double written by write_double()
+ */
+bool Baseline::read_double(std::istream& in, double& value)
+{
+  std::uint64_t bits = 0;
+  for (int i = 0; i < 8; ++i)
+  {
+    const int byte = in.get();
+    if (byte == std::char_traits<char>::eof())
+      return false;
+    bits |= static_cast<std::uint64_t>(byte) << (i * 8);
+  }
+  value = std::bit_cast<double>(bits);
+  return true;
+}
+
+/**
+ * \brief Write the histogram, only the non-empty buckets are written (as the distance to the previous bucket and the count)
+ */
+void Baseline::write_histogram(std::ostream& out, const Histogram& histogram)
+{
+  write_varint(out, histogram.count_);
+  if (histogram.count_ == 0)
+    return;
+  write_varint(out, histogram.min_);
+  write_varint(out, histogram.max_);
+  write_double(out, histogram.sum_);
+  const auto non_empty = std::count_if(histogram.buckets_.begin(), histogram.buckets_.end(), [](std::uint64_t count) { return count > 0; });
+  write_varint(out, static_cast<std::uint64_t>(non_empty));
+  std::size_t previous = 0;
+  for (std::size_t i = 0; i < Histogram::bucket_count_; ++i)
+  {
+    if (histogram.buckets_[i] == 0)
+      continue;
+    write_varint(out, i - previous);
+    write_varint(out, histogram.buckets_[i]);
+    previous = i;
+  }
+}
+
+/**
+ * \brief Read a histogram written by write_histogram()
+ * \return False on a read error or when the buckets do not match the total count
+ */
+bool Baseline::read_histogram(std::istream& in, Histogram& histogram)
+{
+  histogram.reset();
+  if (!read_varint(in, histogram.count_))
+    return false;
+  if (histogram.count_ == 0)
+    return true;
+
+  std::uint64_t non_empty = 0;
+  if (!read_varint(in, histogram.min_) || !read_varint(in, histogram.max_) || !read_double(in, histogram.sum_) || !read_varint(in, non_empty))
+    return false;
+  std::uint64_t index = 0;
+  std::uint64_t total = 0;
+  for (std::uint64_t i = 0; i < non_empty; ++i)
+  {
+    std::uint64_t distance = 0;
+    std::uint64_t count = 0;
+    if (!read_varint(in, distance) || !read_varint(in, count))
+      return false;
+    index += distance;
+    if (index >= Histogram::bucket_count_)
+      return false;
+    histogram.buckets_[index] = count;
+    total += count;
+  }
+  return total == histogram.count_;
+}
+
+/**
+ * \brief Write the values of every second (count and the values)
+ */
+void Baseline::write_samples(std::ostream& out, const std::vector<double>& samples)
+{
+  write_varint(out, samples.size());
+  for (const double sample : samples)
+  {
+    write_double(out, sample);
+  }
+}
+
+/**
+ * \brief Read the values written by write_samples()
+ */
+bool Baseline::read_samples(std::istream& in, std::vector<double>& samples)
+{
+  std::uint64_t count = 0;
+  if (!read_varint(in, count))
+    return false;
+  samples.clear();
+  for (std::uint64_t i = 0; i < count; ++i)
+  {
+    double sample = 0;
+    if (!read_double(in, sample))
+      return false;
+    samples.push_back(sample);
+  }
+  return true;
+}
+
+/**
+ * \brief Welch's t-test on the mean of two samples (unequal variances)
+ * \return Two-sided p-value, 1.0 when one of the samples is too small
+ */
+double Baseline::welch_t_test(const std::vector<double>& a, const std::vector<double>& b)
+{
+  if (a.size() < min_samples_ || b.size() < min_samples_)
+    return 1.0;
+
+  auto mean_variance = [](const std::vector<double>& samples)
+  {
+    double mean = 0;
+    for (const double sample : samples)
+      mean += sample;
+    mean /= samples.size();
+    double variance = 0;
+    for (const double sample : samples)
+      variance += (sample - mean) * (sample - mean);
+    return std::make_pair(mean, variance / (samples.size() - 1));
+  };
+  const auto [mean_a, variance_a] = mean_variance(a);
+  const auto [mean_b, variance_b] = mean_variance(b);
+
+  const double error_a = variance_a / a.size();
+  const double error_b = variance_b / b.size();
+  if (error_a + error_b == 0)
+    return (mean_a == mean_b) ? 1.0 : 0.0;
+
+  const double t = (mean_a - mean_b) / std::sqrt(error_a + error_b);
+  const double degrees_of_freedom =
+      (error_a + error_b) * (error_a + error_b) / (error_a * error_a / (a.size() - 1) + error_b * error_b / (b.size() - 1));
+  // Two-sided p-value of the Student's t-distribution
+  return incomplete_beta(degrees_of_freedom / 2.0, 0.5, degrees_of_freedom / (degrees_of_freedom + t * t));
+}
+
+/**
+ * \brief Two-proportion z-test (eg. error rates)
+ * \return Two-sided p-value
+ */
+double Baseline::two_proportion_test(std::uint64_t successes_a, std::uint64_t total_a, std::uint64_t successes_b, std::uint64_t total_b)
+{
+  if (total_a == 0 || total_b == 0)
+    return 1.0;
+
+  const double pooled = static_cast<double>(successes_a + successes_b) / (total_a + total_b);
+  const double standard_error = std::sqrt(pooled * (1.0 - pooled) * (1.0 / total_a + 1.0 / total_b));
+  if (standard_error == 0)
+    return 1.0;
+  const double z = (static_cast<double>(successes_a) / total_a - static_cast<double>(successes_b) / total_b) / standard_error;
+  return std::erfc(std::abs(z) / std::sqrt(2.0));
+}
+
+/**
+ * \brief Regularized incomplete beta function I_x(a, b), using the continued fraction (modified Lentz's method)
+ */
+double Baseline::incomplete_beta(double a, double b, double x)
+{
+  if (x <= 0)
+    return 0.0;
+  if (x >= 1)
+    return 1.0;
+
+  auto continued_fraction = [](double a, double b, double x)
+  {
+    constexpr double tiny = 1e-300;
+    auto not_zero = [](double value) { return (std::abs(value) < tiny) ? tiny : value; };
+    double c = 1.0;
+    double d = 1.0 / not_zero(1.0 - (a + b) * x / (a + 1.0));
+    double result = d;
+    for (int m = 1; m <= 300; ++m)
+    {
+      // Even step
+      double numerator = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+      d = 1.0 / not_zero(1.0 + numerator * d);
+      c = not_zero(1.0 + numerator / c);
+      result *= d * c;
+      // Odd step
+      numerator = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+      d = 1.0 / not_zero(1.0 + numerator * d);
+      c = not_zero(1.0 + numerator / c);
+      const double delta = d * c;
+      result *= delta;
+      if (std::abs(delta - 1.0) < 1e-12)
+        break;
+    }
+    return result;
+  };
+
+  const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+  // The continued fraction converges fast for x < (a + 1) / (a + b + 2), otherwise use the symmetry relation
+  if (x < (a + 1.0) / (a + b + 2.0))
+    return front * continued_fraction(a, b, x) / a;
+  return 1.0 - front * continued_fraction(b, a, 1.0 - x) / b;
+}
@@ -1,10 +1,27 @@
 
+#include <asio/buffer.hpp>
+#include <asio/buffers_iterator.hpp>
 #include <asio/connect.hpp>
+#include <asio/local/stream_protocol.hpp>
 #include <asio/read.hpp>
 #include <asio/read_until.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
 #include <iostream>
+#include <limits>
 #include <openssl/ssl.h>
 #include <regex>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include "client.h"
 #include "project_config.h"
@@ -14,13 +31,20 @@
  */
 Client::Client(const Settings& settings, asio::io_context& io_context)
     : url_(settings.url),
-      post_data_(settings.post_data),
+      method_(settings.method),
+      host_header_(settings.host),
       verbose_(settings.verbose),
       silent_(settings.silent),
       verify_peer_(settings.verify_peer),
       override_verify_tls_(settings.override_verify_tls),
       debug_verify_tls_(settings.debug),
       ssl_options_(settings.ssl_options),
+      mode_(settings.mode),
+      tls_resume_(settings.tls_resume),
+      connect_timeout_(settings.connect_timeout_ms),
+      handshake_timeout_(settings.handshake_timeout_ms),
+      first_byte_timeout_(settings.first_byte_timeout_ms),
+      total_timeout_(settings.total_timeout_ms),
       io_context_(io_context)
 {
   if (ssl_options_ == 0)
@@ -34,12 +58,36 @@ Client::Client(const Settings& settings, asio::io_context& io_context)
   {
     std::regex expression("([\\w]+)://([^:/]+)(?::(\\d+))?(/.*)?");
     std::smatch matched_url;
-    if (std::regex_match(url_, matched_url, expression))
+    if (url_.compare(0, 7, "unix://") == 0)
+    {
+      // Unix domain socket, optionally followed by the HTTP path: unix:///path/to.sock:/path
+      // The HTTP path starts at the first ":/", so the socket path can contain a colon (eg. /run/app:8080.sock)
+      const std::string target = url_.substr(7);
+      const std::size_t path_separator = target.find(":/");
+      const std::string socket_path = target.substr(0, path_separator);
+      if (socket_path.empty())
+      {
+        std::cerr << "Error: Missing the socket path in the Unix domain socket URL (eg. unix:///run/app.sock:/path). Exit!" << std::endl;
+        exit(1);
+      }
+      std::string rest = (path_separator == std::string::npos) ? std::string("/") : target.substr(path_separator + 1);
+
+      // No DNS lookup is needed
+      unix_endpoint_ = asio::local::stream_protocol::endpoint(socket_path);
+      dns_lookup_duration_ = std::chrono::milliseconds::zero();
+
+      // Store the parsed URL, the Host header is set to localhost (unless overridden)
+      protocol_ = "unix";
+      host_ = "localhost";
+      path_params_ = std::move(rest);
+    }
+    else if (std::regex_match(url_, matched_url, expression))
     {
       const auto start_dns_lookup_time_point = std::chrono::steady_clock::now();
       asio::ip::tcp::resolver resolver(io_context_);
-      // Resolve the server hostname and service
-      resolve_result_ = resolver.resolve(std::string(matched_url[2]), std::string(matched_url[1]));
+      // Resolve the server hostname and service (or the port when given in the URL)
+      std::string service = matched_url[3].str().empty() ? std::string(matched_url[1]) : std::string(matched_url[3]);
+      resolve_result_ = resolver.resolve(std::string(matched_url[2]), service);
       const auto end_dns_lookup_time_point = std::chrono::steady_clock::now();
       dns_lookup_duration_ = end_dns_lookup_time_point - start_dns_lookup_time_point;
 
@@ -62,6 +110,25 @@ Client::Client(const Settings& settings, asio::io_context& io_context)
       std::cerr << "Error: URL did not match the expected pattern. Exit!" << std::endl;
       exit(1);
     }
+
+    if (protocol_.compare("https") == 0)
+    {
+      create_tls_context(settings);
+    }
+    if (!settings.body_file.empty())
+    {
+      // Map the body file once, all requests send the body from this mapping
+      body_file_ = std::make_unique<MappedFile>();
+      if (!body_file_->open(settings.body_file))
+      {
+        std::cerr << "Error: Could not open body file: " << settings.body_file << ". Exit." << std::endl;
+        exit(1);
+      }
+    }
+    if (mode_ == TestMode::Http)
+    {
+      request_ = build_request(settings.post_data);
+    }
   }
   catch (std::exception& e)
   {
@@ -76,48 +143,65 @@ Client::~Client()
 {
 }
 
+/**
+ * \brief Build the HTTP request, the request is the same for every request so it is only build once
+ * \param post_data JSON post data, appended to the request (the request is the only copy kept of the data)
+ */
+std::string Client::build_request(const std::string& post_data) const
+{
+  std::string request;
+  // Headers are (much) smaller than 1 KiB, the post data is appended without re-allocating
+  request.reserve(1024 + post_data.size());
+  request += method_ + " " + path_params_ + " HTTP/1.0\r\n";
+  std::string hostname(host_header_.empty() ? host_ : host_header_);
+  if (host_header_.empty() && !empty(port_))
+  {
+    hostname.append(":" + port_);
+  }
+  request += "Host: " + hostname + "\r\n";
+  request += std::string("User-Agent: RamBam/") + PROJECT_VER + "\r\n";
+  if (!empty(post_data))
+  {
+    request += "Content-Type: application/json; charset=utf-8\r\n";
+    request += "Accept: */*\r\n"; // We should be able to override this (eg. application/json)
+    request += "Content-Length: " + std::to_string(post_data.length()) + "\r\n";
+  }
+  else if (body_file_ != nullptr)
+  {
+    // The body itself is send straight from the file (see write_body_file())
+    request += "Content-Type: application/octet-stream\r\n";
+    request += "Accept: */*\r\n";
+    request += "Content-Length: " + std::to_string(body_file_->size()) + "\r\n";
+  }
+  else if (method_ == "POST" || method_ == "PUT" || method_ == "PATCH")
+  {
+    request += "Content-Length: 0\r\n";
+  }
+  request += "Connection: close\r\n\r\n"; // End is a double line feed
+  request += post_data;
+  return request;
+}
+
 /**
  * \brief Do the HTTP(s) request reusing the same settings for each request.
+ * \param state State of the connection executing the request (eg. TLS session for resumption)
+ * \return The result of the request, status is set to error if the request failed
+ * \details Coroutine, the socket is created on the executor of the calling coroutine.
+ * In connect or handshake test mode, only the connection (and TLS handshake) is done.
+ * Each phase has its own timeout (connect, handshake and first byte), all within the total timeout.
+ * On a timeout the socket is closed, cancelling the pending operation.
  */
-void Client::do_request() const
+asio::awaitable<ResultResponse> Client::do_request(ConnectionState& state) const
 {
   // Start time measurement
   const auto start_prepare_request_time_point = std::chrono::steady_clock::now();
-  ResultResponse result;
+  const auto total_deadline = Client::deadline(start_prepare_request_time_point, total_timeout_, std::chrono::steady_clock::time_point::max());
+  // The reply of the previous request is released, the arena memory is re-used for this request
+  state.start_request();
+  ResultResponse result(state.arena());
 
   try
   {
-    // Prepare HTTP request
-    asio::streambuf request;
-    std::ostream request_stream(&request);
-    // We should also support: DELETE, PUT, PATCH
-    if (empty(post_data_))
-    {
-      request_stream << "GET " + path_params_ + " HTTP/1.0\r\n";
-    }
-    else
-    {
-      request_stream << "POST " + path_params_ + " HTTP/1.0\r\n";
-    }
-    std::string hostname(host_);
-    if (!empty(port_))
-    {
-      hostname.append(":" + port_);
-    }
-    request_stream << "Host: " + hostname + "\r\n";
-    request_stream << "User-Agent: RamBam/" << PROJECT_VER << "\r\n";
-    if (!empty(post_data_))
-    {
-      request_stream << "Content-Type: application/json; charset=utf-8\r\n";
-      request_stream << "Accept: */*\r\n"; // We should be able to override this (eg. application/json)
-      request_stream << "Content-Length: " << post_data_.length() << "\r\n";
-    }
-    request_stream << "Connection: close\r\n\r\n"; // End is a double line feed
-    if (!empty(post_data_))
-    {
-      request_stream << post_data_;
-    }
-
     // Note: the end of prepare request time point is the start of socket connect time point
     const auto end_prepare_request_time_point = std::chrono::steady_clock::now();
     std::chrono::duration<double, std::milli> prepare_request_time_duration = end_prepare_request_time_point - start_prepare_request_time_point;
@@ -125,65 +209,82 @@ void Client::do_request() const
     // Pre-define to zero
     std::chrono::duration<double, std::milli> socket_connect_time_duration = std::chrono::milliseconds::zero();
     std::chrono::duration<double, std::milli> handshake_time_duration = std::chrono::milliseconds::zero();
-    if (protocol_.compare("http") == 0)
+    bool tls_resumed = false;
+    auto executor = co_await asio::this_coro::executor;
+    if (protocol_.compare("unix") == 0)
     {
-      // Create and connect the plain TCP socket
-      asio::ip::tcp::socket socket(io_context_);
-      asio::connect(socket, resolve_result_);
+      // Create and connect the Unix domain socket, plain HTTP without the TCP/IP overhead
+      asio::local::stream_protocol::socket socket(executor);
+      state.watch(socket);
+      state.expires_at(Client::deadline(end_prepare_request_time_point, connect_timeout_, total_deadline));
+      co_await socket.async_connect(unix_endpoint_, asio::use_awaitable);
       const auto end_socket_connect_time_point = std::chrono::steady_clock::now();
       socket_connect_time_duration = end_socket_connect_time_point - end_prepare_request_time_point;
-      result = Client::handle_request(socket, request);
+      if (mode_ == TestMode::Http)
+      {
+        result = co_await handle_request(socket, state, total_deadline);
+      }
       socket.close();
     }
-    else if (protocol_.compare("https") == 0)
+    else if (protocol_.compare("http") == 0 || mode_ == TestMode::Connect)
     {
-      // Create and connect the socket using the TLS protocol
-      // TODO: Give the user more control about the context, like tlsv1.2 maybe?
-      asio::ssl::context tls_context(asio::ssl::context::tlsv13_client);
-      // Only allow TLS v1.2 & v1.3 by default
-      tls_context.set_options(ssl_options_);
-
-      // Verify TLS connection by default
-      if (verify_peer_)
-      {
-        // Verify TLS connection
-        tls_context.set_verify_mode(asio::ssl::verify_peer);
-        // Set default CA paths
-        tls_context.set_default_verify_paths();
-
-        // Verify the remote host's certificate
-        if (debug_verify_tls_)
-        {
-          tls_context.set_verify_callback(std::bind(&Client::verify_certificate_callback, this, std::placeholders::_1, std::placeholders::_2));
-        }
-        else
-        {
-          // By default use the built-in host_name_verification()
-          tls_context.set_verify_callback(asio::ssl::host_name_verification(host_));
-        }
-      }
-      else
+      // Create and connect the plain TCP socket
+      asio::ip::tcp::socket socket(executor);
+      state.watch(socket);
+      state.expires_at(Client::deadline(end_prepare_request_time_point, connect_timeout_, total_deadline));
+      co_await asio::async_connect(socket, resolve_result_, asio::use_awaitable);
+      const auto end_socket_connect_time_point = std::chrono::steady_clock::now();
+      socket_connect_time_duration = end_socket_connect_time_point - end_prepare_request_time_point;
+      if (mode_ == TestMode::Http)
       {
-        tls_context.set_verify_mode(asio::ssl::context::verify_none);
+        result = co_await handle_request(socket, state, total_deadline);
       }
-
-      asio::ssl::stream<asio::ip::tcp::socket> socket(io_context_, tls_context);
+      socket.close();
+    }
+    else if (protocol_.compare("https") == 0)
+    {
+      // Create and connect the socket using the TLS protocol, the TLS context is shared by all connections
+      asio::ssl::stream<asio::ip::tcp::socket> socket(executor, *tls_context_);
+      SSL* ssl = socket.native_handle();
 
       // Set SNI
-      SSL_set_tlsext_host_name(socket.native_handle(), host_.c_str());
+      SSL_set_tlsext_host_name(ssl, host_.c_str());
 
-      asio::connect(socket.next_layer(), resolve_result_);
+      if (tls_resume_)
+      {
+        // New sessions of this connection are stored by the new session callback
+        SSL_set_ex_data(ssl, Client::connection_state_index(), &state);
+        if (state.tls_session() != nullptr)
+          SSL_set_session(ssl, state.tls_session());
+      }
+
+      state.watch(socket.next_layer());
+      state.expires_at(Client::deadline(end_prepare_request_time_point, connect_timeout_, total_deadline));
+      co_await asio::async_connect(socket.next_layer(), resolve_result_, asio::use_awaitable);
 
       // Note: end of socket connect time point is the start of the handshake time point
       const auto end_socket_connect_time_point = std::chrono::steady_clock::now();
       socket_connect_time_duration = end_socket_connect_time_point - end_prepare_request_time_point;
 
       // Perform TLS handshake
-      socket.handshake(asio::ssl::stream_base::client);
+      state.expires_at(Client::deadline(end_socket_connect_time_point, handshake_timeout_, total_deadline));
+      co_await socket.async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
       const auto end_handshake_time_point = std::chrono::steady_clock::now();
       handshake_time_duration = end_handshake_time_point - end_socket_connect_time_point;
+      tls_resumed = SSL_session_reused(ssl) == 1;
 
-      result = Client::handle_request(socket, request);
+      if (mode_ == TestMode::Http)
+      {
+        result = co_await handle_request(socket, state, total_deadline);
+      }
+      if (tls_resume_)
+      {
+        // Graceful shutdown, OpenSSL does not resume sessions of connections closed without a close_notify.
+        // This also reads the TLS v1.3 session tickets (send after the handshake). Errors are ignored.
+        state.expires_at(Client::deadline(std::chrono::steady_clock::now(), handshake_timeout_, total_deadline));
+        asio::error_code error;
+        co_await socket.async_shutdown(asio::redirect_error(asio::use_awaitable, error));
+      }
       socket.next_layer().close();
     }
     else
@@ -191,6 +292,7 @@ void Client::do_request() const
       std::cerr << "Error: Unsupported protocol (for now). Exit." << std::endl;
       exit(1);
     }
+    result.tls_resumed = tls_resumed;
     result.duration.dns = dns_lookup_duration_;
     result.duration.prepare_request = prepare_request_time_duration;
     result.duration.connect = socket_connect_time_duration;
@@ -201,41 +303,141 @@ void Client::do_request() const
         (result.duration.prepare_request + result.duration.connect + result.duration.handshake + result.duration.request + result.duration.response);
     // Total with DNS time (altough it's only done once per thread)
     result.duration.total = result.duration.total_without_dns + result.duration.dns;
-
-    // TODO: We return the result, print it outside of this method.
-    if (!silent_ && verbose_)
+  }
+  catch (const asio::system_error& e)
+  {
+    result.duration.total_without_dns = std::chrono::steady_clock::now() - start_prepare_request_time_point;
+    if (state.timed_out())
     {
-      std::cout << "Response: " << result.reply.http_version << " " << std::to_string(result.reply.status_code) << " " << result.reply.status_message
-                << std::endl;
-      std::cout << "Total duration: " << result.duration.total_without_dns.count() << "ms (prepare: " << result.duration.prepare_request.count()
-                << "ms, socket connect: " << result.duration.connect.count() << "ms, handshake: " << result.duration.handshake.count()
-                << "ms, request: " << result.duration.request.count() << "ms, response: " << result.duration.response.count() << "ms)" << std::endl;
-      std::cout << "Body Content:\n" << result.reply.body << std::endl;
-      std::cout << "Headers:\n" << std::endl;
-      for (const auto& header : result.reply.headers)
-      {
-        std::cout << "Name: " << header.first << " Value: " << header.second << std::endl;
-      }
-      std::cout << "------------------------------------------------------\n\r" << std::endl;
+      result.status = ResultStatus::Timeout;
     }
-    else if (!silent_)
+    else
     {
-      // TODO: Something is off with result.reply.status_message (hidden special chars?)
-      // We should silent this by default! Instead, show some process bar...
-      // std::cout << "Response: " << std::to_string(result.reply.status_code) << " in " << result.duration.total_without_dns.count() << "ms"
-      //          << std::endl;
+      result.status = ResultStatus::Error;
+      // Printed by the aggregator, writing to the console here would serialize the workers
+      if (!silent_)
+        result.error.append("Could not perform the HTTP(s) request: ").append(e.what());
     }
   }
-  catch (const asio::system_error& e)
+  catch (const std::exception& e)
   {
-    std::cerr << "Error: Could not perform the HTTP(s) request: " << e.what() << std::endl;
+    result.status = ResultStatus::Error;
+    result.duration.total_without_dns = std::chrono::steady_clock::now() - start_prepare_request_time_point;
+    if (!silent_)
+      result.error.append("Something went wrong during the request: ").append(e.what());
   }
-  catch (const std::exception& e)
+  state.finish_request();
+  co_return result;
+}
+
+/**
+ * \brief Get the deadline of a phase, never later than the given (total) deadline
+ * \param start Start of the phase
+ * \param timeout Timeout of the phase, zero means no timeout
+ * \param max_deadline Deadline limit (eg. the total deadline)
+ */
+std::chrono::steady_clock::time_point
+Client::deadline(std::chrono::steady_clock::time_point start, std::chrono::milliseconds timeout, std::chrono::steady_clock::time_point max_deadline)
+{
+  if (timeout.count() <= 0)
+    return max_deadline;
+  return std::min(start + timeout, max_deadline);
+}
+
+/**
+ * \brief Create the TLS context, shared by all connections
+ * \param settings The settings struct
+ */
+void Client::create_tls_context(const Settings& settings)
+{
+  tls_context_ = std::make_unique<asio::ssl::context>(asio::ssl::context::tls_client);
+  tls_context_->set_options(ssl_options_);
+
+  SSL_CTX* ctx = tls_context_->native_handle();
+  // Pin the TLS version, TLS v1.3 by default
+  int tls_version = TLS1_3_VERSION;
+  if (settings.tls_version.compare("1.2") == 0)
+  {
+    tls_version = TLS1_2_VERSION;
+  }
+  else if (!settings.tls_version.empty() && settings.tls_version.compare("1.3") != 0)
+  {
+    std::cerr << "Error: Unsupported TLS version: " << settings.tls_version << " (use 1.2 or 1.3). Exit." << std::endl;
+    exit(1);
+  }
+  SSL_CTX_set_min_proto_version(ctx, tls_version);
+  SSL_CTX_set_max_proto_version(ctx, tls_version);
+
+  if (!settings.ciphers.empty() && SSL_CTX_set_cipher_list(ctx, settings.ciphers.c_str()) != 1)
+  {
+    std::cerr << "Error: Invalid TLS cipher list: " << settings.ciphers << ". Exit." << std::endl;
+    exit(1);
+  }
+  if (!settings.ciphersuites.empty() && SSL_CTX_set_ciphersuites(ctx, settings.ciphersuites.c_str()) != 1)
+  {
+    std::cerr << "Error: Invalid TLS v1.3 cipher suites: " << settings.ciphersuites << ". Exit." << std::endl;
+    exit(1);
+  }
+  if (!settings.curves.empty() && SSL_CTX_set1_groups_list(ctx, settings.curves.c_str()) != 1)
+  {
+    std::cerr << "Error: Invalid ECDHE curves: " << settings.curves << ". Exit." << std::endl;
+    exit(1);
+  }
+
+  if (tls_resume_)
   {
-    std::cerr << "Error: Something went wrong during the request: " << e.what() << std::endl;
+    // Sessions are kept per connection (see ConnectionState), not in the internal cache of the context
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &Client::new_session_callback);
+  }
+
+  // Verify TLS connection by default
+  if (verify_peer_)
+  {
+    // Verify TLS connection
+    tls_context_->set_verify_mode(asio::ssl::verify_peer);
+    // Set default CA paths
+    tls_context_->set_default_verify_paths();
+
+    // Verify the remote host's certificate
+    if (debug_verify_tls_)
+    {
+      tls_context_->set_verify_callback(std::bind(&Client::verify_certificate_callback, this, std::placeholders::_1, std::placeholders::_2));
+    }
+    else
+    {
+      // By default use the built-in host_name_verification()
+      tls_context_->set_verify_callback(asio::ssl::host_name_verification(host_));
+    }
+  }
+  else
+  {
+    tls_context_->set_verify_mode(asio::ssl::context::verify_none);
   }
 }
 
+/**
+ * \brief Index of the connection state in the SSL ex data
+ */
+int Client::connection_state_index()
+{
+  static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+/**
+ * \brief OpenSSL callback for a new TLS session, store the session in the connection state for resumption
+ * \return 1 when the session is stored (we keep the reference), 0 otherwise
+ */
+int Client::new_session_callback(SSL* ssl, SSL_SESSION* session)
+{
+  auto* state = static_cast<ConnectionState*>(SSL_get_ex_data(ssl, Client::connection_state_index()));
+  if (state == nullptr)
+    return 0;
+  state->set_tls_session(session);
+  return 1;
+}
+
 /**
  * Debug certificate validation callback method
  */
@@ -277,38 +479,110 @@ bool Client::verify_certificate_callback(bool preverified, asio::ssl::verify_con
 /**
  * \brief Handle HTTP(s) request
  * \param[in] socket Socket connection
- * \param[in] request Request data
+ * \param[in] state Connection state, used for the first byte timeout and the arena
+ * \param[in] total_deadline Deadline of the whole request
  */
-template <typename SyncReadStream> ResultResponse Client::handle_request(SyncReadStream& socket, asio::streambuf& request)
+template <typename AsyncStream>
+asio::awaitable<ResultResponse>
+Client::handle_request(AsyncStream& socket, ConnectionState& state, std::chrono::steady_clock::time_point total_deadline) const
 {
-  ResultResponse result;
+  ResultResponse result(state.arena());
 
   const auto start_request_time_point = std::chrono::steady_clock::now();
-  asio::write(socket, request);
+  state.expires_at(total_deadline);
+  if (body_file_ != nullptr)
+    result.sent = co_await write_body_file(socket);
+  else
+    result.sent = co_await asio::async_write(socket, asio::buffer(request_), asio::use_awaitable);
 
   // Note: End _request_ time point is now also the start of the _response_ time point
   const auto end_request_time_point = std::chrono::steady_clock::now();
   result.duration.request = end_request_time_point - start_request_time_point;
 
-  result.reply = Client::parse_response(socket);
+  state.expires_at(Client::deadline(end_request_time_point, first_byte_timeout_, total_deadline));
+  result.reply = co_await Client::parse_response(socket, state, total_deadline);
 
   const auto end_response_time_point = std::chrono::steady_clock::now();
   result.duration.response = end_response_time_point - end_request_time_point;
 
-  return result;
+  co_return result;
 }
 
+/**
+ * \brief Write the request with the body of the body file
+ * \param[in] socket Socket connection
+ * \return Number of bytes sent
+ * \details Scatter-gather write of the request and the first chunk of the body, followed by the remaining chunks.
+ * The body is send straight from the memory mapping. Reading the mapping of a truncated file raises SIGBUS, so the
+ * file size is checked before every chunk (only a truncation during a single chunk is not caught).
+ */
+template <typename AsyncStream> asio::awaitable<std::size_t> Client::write_body_file(AsyncStream& socket) const
+{
+  auto chunk = [this](std::size_t offset)
+  {
+    if (body_file_->truncated())
+      throw asio::system_error(asio::error::eof, "Body file is truncated");
+    return asio::buffer(body_file_->data() + offset, std::min(body_file_chunk_size_, body_file_->size() - offset));
+  };
+
+  const std::array<asio::const_buffer, 2> buffers{asio::buffer(request_), chunk(0)};
+  std::size_t sent = co_await asio::async_write(socket, buffers, asio::use_awaitable);
+  for (std::size_t offset = body_file_chunk_size_; offset < body_file_->size(); offset += body_file_chunk_size_)
+  {
+    sent += co_await asio::async_write(socket, chunk(offset), asio::use_awaitable);
+  }
+  co_return sent;
+}
+
+#ifdef __linux__
+/**
+ * \brief Write the request with the body of the body file on a plain (TCP or Unix domain) socket
+ * \param[in] socket Socket connection
+ * \return Number of bytes sent
+ * \details The body is send using sendfile(), the kernel copies the file directly from the page cache to the socket.
+ */
+template <typename Protocol, typename Executor>
+asio::awaitable<std::size_t> Client::write_body_file(asio::basic_stream_socket<Protocol, Executor>& socket) const
+{
+  std::size_t sent = co_await asio::async_write(socket, asio::buffer(request_), asio::use_awaitable);
+
+  socket.native_non_blocking(true);
+  off_t offset = 0;
+  const auto size = static_cast<off_t>(body_file_->size());
+  while (offset < size)
+  {
+    // The offset is updated by sendfile, the file offset itself is not changed (the file is shared by all connections)
+    const ssize_t result = ::sendfile(socket.native_handle(), body_file_->native_handle(), &offset, static_cast<std::size_t>(size - offset));
+    if (result > 0)
+      continue;
+    // Nothing left to send before the end of the body, the file is truncated after it was mapped
+    if (result == 0)
+      throw asio::system_error(asio::error::eof, "Body file is truncated");
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      co_await socket.async_wait(asio::socket_base::wait_write, asio::use_awaitable);
+    else if (errno != EINTR)
+      throw asio::system_error(asio::error_code(errno, asio::error::get_system_category()), "Error during sending the body file");
+  }
+  co_return sent + static_cast<std::size_t>(size);
+}
+#endif
+
 /**
  * \brief Parse response: HTTP status, headers and body
  * \param[in] socket Socket connection
+ * \param[in] state Connection state, used for the timeout and the arena (all memory of the reply is allocated from the arena)
+ * \param[in] total_deadline Deadline of the whole request, used after the first byte is received
  */
-template <typename SyncReadStream> Reply Client::parse_response(SyncReadStream& socket)
+template <typename AsyncStream>
+asio::awaitable<Reply> Client::parse_response(AsyncStream& socket, ConnectionState& state, std::chrono::steady_clock::time_point total_deadline)
 {
-  Reply reply;
-  asio::streambuf response;
+  Reply reply(state.arena());
+  ResponseBuffer response(std::numeric_limits<std::size_t>::max(), std::pmr::polymorphic_allocator<char>(state.arena()));
 
   // Read until the status line
-  asio::read_until(socket, response, "\r\n");
+  const std::size_t status_line_size = co_await asio::async_read_until(socket, response, "\r\n", asio::use_awaitable);
+  // First byte is received, the rest of the response only needs to meet the total deadline
+  state.expires_at(total_deadline);
 
   // Get HTTP Status lines
   std::istream response_stream(&response);
@@ -316,61 +590,70 @@ template <typename SyncReadStream> Reply Client::parse_response(SyncReadStream&
   response_stream >> reply.status_code;
   std::getline(response_stream, reply.status_message);
 
-  // Get till all the headers, can we improve the performance of this call?
-  asio::read_until(socket, response, "\r\n\r\n");
+  // Get till all the headers
+  const std::size_t headers_size = co_await asio::async_read_until(socket, response, "\r\n\r\n", asio::use_awaitable);
   // Extract headers
-  std::string header_line;
+  std::pmr::string header_line(state.arena());
   bool chunked = false;
-  int response_content_length = -1;
-  std::regex content_length_pattern(R"xx(^content-length:\s+(\d+))xx", std::regex_constants::icase);
-  std::regex transfer_encoding_pattern(R"xx(^transfer-encoding:\s+chunked)xx", std::regex_constants::icase);
+  long response_content_length = -1;
   while (std::getline(response_stream, header_line) && header_line != "\r")
   {
-    size_t colon_pos = header_line.find(':');
-    if (colon_pos != std::string::npos)
-    {
-      std::string header_name = header_line.substr(0, colon_pos);
-      std::string header_value = header_line.substr(colon_pos + 2); // Skip ': ' after colon
-      reply.headers.emplace_back(std::move(header_name), std::move(header_value));
-    }
-    std::smatch match;
-    if (std::regex_search(header_line, match, content_length_pattern))
-      response_content_length = std::stoi(match[1]);
-    if (std::regex_search(header_line, match, transfer_encoding_pattern))
+    std::string_view line(header_line);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    size_t colon_pos = line.find(':');
+    if (colon_pos == std::string_view::npos)
+      continue;
+
+    const std::string_view header_name = line.substr(0, colon_pos);
+    std::string_view header_value = line.substr(colon_pos + 1);
+    header_value.remove_prefix(std::min(header_value.find_first_not_of(" \t"), header_value.size()));
+    reply.headers.emplace_back(header_name, header_value);
+    if (Client::equals_ignore_case(header_name, "content-length"))
+      std::from_chars(header_value.data(), header_value.data() + header_value.size(), response_content_length);
+    else if (Client::equals_ignore_case(header_name, "transfer-encoding") && Client::equals_ignore_case(header_value.substr(0, 7), "chunked"))
       chunked = true;
   }
 
+  // The request fails, the error is printed by the aggregator (writing to the console here would serialize the workers)
   if (chunked)
-  {
-    std::cerr << "Error: We do not support chunked responses." << std::endl;
-  }
+    throw std::runtime_error("We do not support chunked responses");
+
+  // The body is read straight into the reply (arena memory), only the part received together with the headers is copied
+  reply.body.assign(asio::buffers_begin(response.data()), asio::buffers_end(response.data()));
 
   // Get body response using the length indicated by the content-length. Or read all, if header was not present.
   if (response_content_length != -1)
   {
-    response_content_length -= response.size();
-    if (response_content_length > 0)
-      asio::read(socket, response, asio::transfer_exactly(response_content_length));
-
-    std::stringstream re;
-    re << &response;
-    reply.body = re.str();
+    const long remaining_length = response_content_length - static_cast<long>(reply.body.size());
+    if (remaining_length > 0)
+    {
+      reply.body.reserve(static_cast<std::size_t>(response_content_length));
+      co_await asio::async_read(socket, asio::dynamic_buffer(reply.body), asio::transfer_exactly(remaining_length), asio::use_awaitable);
+    }
   }
   else
   {
     // Read all non-chunked data at once
     asio::error_code error;
-    asio::read(socket, response, asio::transfer_all(), error);
+    co_await asio::async_read(socket, asio::dynamic_buffer(reply.body), asio::transfer_all(), asio::redirect_error(asio::use_awaitable, error));
     // We also ignore stream truncated errors
     if (error != asio::error::eof && error != asio::ssl::error::stream_truncated) // is there also a success error with Asio standalone?
     {
-      std::cerr << "Error: Error during reading HTTP response: " << error.message() << std::endl;
+      // Eg. the socket is closed due to a timeout
+      throw asio::system_error(error, "Error during reading HTTP response");
     }
-
-    std::stringstream re;
-    re << &response;
-    reply.body = re.str();
   }
+  reply.size = status_line_size + headers_size + reply.body.size();
 
-  return reply;
+  co_return reply;
+}
+
+/**
+ * \brief Case insensitive comparison of ASCII strings (eg. HTTP header names)
+ */
+bool Client::equals_ignore_case(std::string_view left, std::string_view right)
+{
+  auto equal_char = [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); };
+  return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), equal_char);
 }
@@ -0,0 +1,87 @@
+#include "connection_state.h"
+
+/**
+ * \brief Constructor
+ * \param executor Executor of the connection, used for the timeout timer
+ */
+ConnectionState::ConnectionState(const asio::any_io_executor& executor)
+    : timer_(executor),
+      arena_pool_(std::pmr::pool_options{0, arena_pool_max_block_size_}),
+      arena_(arena_buffer_.data(), arena_buffer_.size(), &arena_pool_)
+{
+}
+
+/**
+ * \brief Destructor, releases the TLS session
+ */
+ConnectionState::~ConnectionState()
+{
+  if (tls_session_ != nullptr)
+    SSL_SESSION_free(tls_session_);
+}
+
+/**
+ * \brief Store a new TLS session, releasing the previous one
+ * \param session The session, ownership is transferred to this connection state
+ */
+void ConnectionState::set_tls_session(SSL_SESSION* session)
+{
+  if (tls_session_ != nullptr)
+    SSL_SESSION_free(tls_session_);
+  tls_session_ = session;
+}
+
+/**
+ * \brief Set the deadline of the current phase of the request, replacing the previous deadline
+ * \param deadline Deadline, time_point::max() to disable the timeout
+ */
+void ConnectionState::expires_at(std::chrono::steady_clock::time_point deadline)
+{
+  ++generation_;
+  if (deadline == std::chrono::steady_clock::time_point::max())
+  {
+    timer_.cancel();
+    return;
+  }
+  timer_.expires_at(deadline);
+  timer_.async_wait(
+      [weak_self = weak_from_this(), generation = generation_](const asio::error_code& error)
+      {
+        if (error)
+          return; // Cancelled
+        auto self = weak_self.lock();
+        if (self && self->generation_ == generation)
+          self->expire();
+      });
+}
+
+/**
+ * \brief Start a new request, releases all arena memory of the previous request (including its reply)
+ * \details The arena memory is re-used for every request, so in a steady state there are no heap allocations.
+ */
+void ConnectionState::start_request()
+{
+  arena_.release();
+}
+
+/**
+ * \brief Stop the timer and forget the socket at the end of a request
+ */
+void ConnectionState::finish_request()
+{
+  ++generation_;
+  timer_.cancel();
+  socket_ = nullptr;
+  close_socket_ = nullptr;
+  timed_out_ = false;
+}
+
+/**
+ * \brief Deadline passed, close the socket to cancel the pending operation
+ */
+void ConnectionState::expire()
+{
+  timed_out_ = true;
+  if (socket_ != nullptr)
+    close_socket_(socket_);
+}
@@ -1,92 +1,352 @@
 #include <asio.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
+#include "aggregator.h"
+#include "allocation_counter.h"
+#include "baseline.h"
 #include "client.h"
 #include "handler.h"
 #include "output.h"
 #include "settings_struct.h"
+#include "statistics.h"
 
 /**
  * \brief Start the threads
  * \param settings The settings struct
+ * \return Exit code, failure when a regression is detected compared to the baseline (or the comparison is not possible)
  */
-void Handler::start(const Settings& settings)
+int Handler::start(const Settings& settings)
 {
-  int total = 0;
+  const std::size_t number_of_threads = Handler::number_of_threads(settings);
 
+  // Show test information
+  if (!settings.silent)
+  {
+    Output::test_info(number_of_threads, settings);
+  }
+
+  asio::io_context io_context;
+  // Note: DNS lookup is done once, the client is re-used for all requests (and all trials)
+  Client client(settings, io_context);
+
+  if (settings.find_max)
+  {
+    Handler::find_max(settings, client);
+    return EXIT_SUCCESS;
+  }
+
+  // Optional raw log of every single result
+  std::ofstream raw_log;
+  std::ostream* raw_log_ptr = nullptr;
+  if (!settings.raw_log_file.empty())
+  {
+    raw_log.open(settings.raw_log_file);
+    if (!raw_log)
+    {
+      std::cerr << "Error: Could not open raw log file: " << settings.raw_log_file << ". Exit." << std::endl;
+      exit(1);
+    }
+    raw_log << "timestamp_ms,endpoint,status,status_code,bytes,sent,tls_resumed,prepare_us,connect_us,handshake_us,request_us,response_us,total_us\n";
+    raw_log_ptr = &raw_log;
+  }
+
+  // Load the baselines before the test, so an invalid file does not waste a test run
+  Baseline reference;
+  for (const auto& file : settings.compare_files)
+  {
+    Baseline run;
+    if (!run.load(file))
+    {
+      std::cerr << "Error: Could not load baseline file: " << file << ". Exit." << std::endl;
+      exit(1);
+    }
+    reference.merge(run);
+  }
+
+  // The async engine multiplexes the connections on the threads, otherwise there is one connection per thread
+  const std::size_t concurrency = settings.async ? static_cast<std::size_t>(std::max(1, settings.connections)) : number_of_threads;
+  Statistics warmup;
+  Statistics statistics = Handler::run(
+      settings, client, concurrency, settings.requests, std::chrono::seconds(settings.duration_sec), !settings.silent, raw_log_ptr, &warmup);
+  // Only the measurement, the warm-up is excluded
+  const std::chrono::duration<double, std::milli> total_test_duration = statistics.duration();
+
+  // Show test report
+  if (!settings.silent)
+  {
+    Output::display_progress_bar(100); // Always set to 100% now
+    Output::test_report(settings, statistics, warmup, total_test_duration);
+  }
+
+  const Baseline baseline(statistics, total_test_duration);
+  bool regression = false;
+  if (!settings.compare_files.empty())
+  {
+    const Comparison comparison = reference.compare(baseline, settings.regression_threshold, settings.regression_noise_floor);
+    regression = comparison.regression || comparison.insufficient_samples;
+    if (!settings.silent)
+      Output::comparison_report(comparison);
+    if (comparison.insufficient_samples)
+      std::cerr << "Error: Not enough complete seconds to compare against the baseline, the comparison fails" << std::endl;
+  }
+  if (!settings.save_baseline_file.empty() && !baseline.save(settings.save_baseline_file))
+  {
+    std::cerr << "Error: Could not save baseline file: " << settings.save_baseline_file << std::endl;
+    return EXIT_FAILURE;
+  }
+  return regression ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * \brief Get the number of threads to use
+ * \param settings The settings struct
+ */
+std::size_t Handler::number_of_threads(const Settings& settings)
+{
   // By default, use the number of concurrent threads supported (only a hint),
   // could return '0' when not computable.
   std::size_t number_of_threads = (settings.threads == 0) ? std::thread::hardware_concurrency() : settings.threads;
   // Fallback to 4 threads if the number of concurrent threads cannot be computed
   if (number_of_threads == 0)
     number_of_threads = 4;
+  return number_of_threads;
+}
 
-  // Show test information
-  if (!settings.silent)
+/**
+ * \brief Run the requests using a closed loop per connection, blocking call until all connections are finished
+ * \param settings The settings struct
+ * \param client The HTTP client
+ * \param concurrency Number of connections executing requests in parallel
+ * \param requests Total number of requests (only used when duration is zero)
+ * \param duration Test duration, or zero for a number of requests test
+ * \param show_progress Display the progress bar
+ * \param raw_log Optional stream to log every result to, nullptr to disable
+ * \param warmup Optional statistics of the warm-up (output), nullptr to ignore
+ * \return Statistics of all connections (excluding the warm-up)
+ * \details Each thread runs its own single-threaded io_context. By default every thread has a single connection,
+ * the async engine multiplexes the connections on the threads.
+ * With a warm-up (settings), the connections first execute the warm-up requests. The measurement starts when all connections
+ * finished their warm-up, so the threads, io_contexts, arenas and server-side caches are already warm.
+ * Note: every request still opens a new socket, only the TLS session is kept from the warm-up (with TLS resumption).
+ */
+Statistics Handler::run(const Settings& settings,
+                        const Client& client,
+                        std::size_t concurrency,
+                        int requests,
+                        std::chrono::seconds duration,
+                        bool show_progress,
+                        std::ostream* raw_log,
+                        Statistics* warmup)
+{
+  const bool duration_test = duration.count() > 0;
+  const bool warmup_test = settings.warmup_sec > 0 || settings.warmup_requests > 0;
+  auto now = std::chrono::steady_clock::now;
+  const std::size_t threads = settings.async ? std::min(Handler::number_of_threads(settings), concurrency) : concurrency;
+
+  // Results leave the threads via lock-free ring buffers, drained by the aggregator thread
+  Aggregator aggregator(threads, settings.verbose && !settings.silent, raw_log);
+  std::atomic<std::size_t> finished_threads = 0;
+
+  // Divide the requests up front, so the connections do not share a counter
+  auto connection_share = [concurrency](int total, std::size_t connection)
+  { return total / static_cast<int>(concurrency) + ((connection < total % concurrency) ? 1 : 0); };
+
+  aggregator.start(warmup_test ? concurrency : 0);
+  const auto warmup_stop_time = now() + std::chrono::seconds(settings.warmup_sec);
+  asio::thread_pool pool(threads);
+  for (std::size_t thread = 0, connection = 0; thread < threads; ++thread)
   {
-    Output::test_info(number_of_threads, settings);
+    const std::size_t connections = concurrency / threads + ((thread < concurrency % threads) ? 1 : 0);
+    const std::size_t first_connection = connection;
+    connection += connections;
+    asio::post(pool,
+               [&, thread, first_connection, connections]()
+               {
+                 AllocationCounter::track_current_thread();
+#ifdef __linux__
+                 // Profilers can tell the workers apart from the main and aggregator thread (see scripts/benchmark_io_uring.sh)
+                 pthread_setname_np(pthread_self(), "rambam-worker");
+#endif
+                 asio::io_context io_context(1);
+                 for (std::size_t i = first_connection; i < first_connection + connections; ++i)
+                 {
+                   const int warmup_requests = (settings.warmup_sec > 0) ? -1 : connection_share(settings.warmup_requests, i);
+                   const int connection_requests = duration_test ? -1 : connection_share(requests, i);
+                   asio::co_spawn(
+                       io_context,
+                       Handler::connection_loop(client, aggregator, thread, warmup_requests, warmup_stop_time, connection_requests, duration),
+                       asio::detached);
+                 }
+                 io_context.run();
+                 finished_threads.fetch_add(1, std::memory_order_release);
+               });
   }
 
-  asio::thread_pool pool(number_of_threads);
-  asio::io_context io_context;
+  if (show_progress && warmup_test)
+    std::cout << "Warming up..." << std::flush;
+  while (finished_threads.load(std::memory_order_acquire) < threads)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (!show_progress || !aggregator.measuring())
+      continue;
 
-  Client client(settings, io_context);
-  auto worker = [client]() { client.do_request(); };
+    if (duration_test)
+    {
+      const auto stop_time = aggregator.measurement_start() + duration;
+      auto remaining_time = std::max<long>(0, std::chrono::duration_cast<std::chrono::seconds>(stop_time - now()).count());
+      int percentage = 100 - (remaining_time * 100 / duration.count());
+      Output::display_progress_bar(percentage, remaining_time);
+    }
+    else if (requests > 0)
+    {
+      int done = static_cast<int>(aggregator.processed());
+      Output::display_progress_bar(done * 100 / requests, -1, requests - done);
+    }
+  }
+
+  // Wait until all threads are finished
+  pool.join();
+  aggregator.stop();
+  Statistics statistics = aggregator.statistics();
+  if (warmup != nullptr)
+    *warmup = aggregator.warmup_statistics();
+  return statistics;
+}
 
-  const auto start_test_time_point = std::chrono::steady_clock::now();
-  // Duration test?
-  if (settings.duration_sec > 0)
+/**
+ * \brief Execute requests one after another (closed loop)
+ * \param client The HTTP client
+ * \param aggregator The aggregator to push the results to
+ * \param producer Index of the thread, all connections of a thread share the same ring buffer
+ * \param warmup_requests Number of warm-up requests, or -1 to continue until the warm-up stop time (only used during a warm-up)
+ * \param warmup_stop_time Stop time of a warm-up in seconds
+ * \param requests Number of requests to execute, or -1 to continue until the end of the duration
+ * \param duration Duration of a duration test, starts at the start of the measurement
+ * \details The connection state (arena and, with TLS resumption, the TLS session) is kept from the warm-up, the sockets are not.
+ * After the warm-up, the connection waits until all connections finished their warm-up.
+ */
+asio::awaitable<void> Handler::connection_loop(const Client& client,
+                                               Aggregator& aggregator,
+                                               std::size_t producer,
+                                               int warmup_requests,
+                                               std::chrono::steady_clock::time_point warmup_stop_time,
+                                               int requests,
+                                               std::chrono::seconds duration)
+{
+  // Shared pointer, because the timeout timer handler keeps a weak reference
+  auto state = std::make_shared<ConnectionState>(co_await asio::this_coro::executor);
+  if (!aggregator.measuring())
   {
-    std::chrono::seconds execution_duration(settings.duration_sec);
-    auto now = std::chrono::steady_clock::now;
-    auto stop_time = now() + execution_duration;
-    while (true)
+    for (int done = 0; (warmup_requests < 0) ? (std::chrono::steady_clock::now() < warmup_stop_time) : (done < warmup_requests); ++done)
     {
-      auto current_time = now();
-      if (current_time < stop_time)
-      {
-        asio::dispatch(pool, worker);
-        ++total;
-        // Only do the below once every 1000 requests, meaning less resources / CPU time
-        if (!settings.silent && (total % 1000) == 0)
-        {
-          auto remaining_time = std::chrono::duration_cast<std::chrono::seconds>(stop_time - current_time).count();
-          int percentage = 100 - (remaining_time * 100 / settings.duration_sec);
-          Output::display_progress_bar(percentage, remaining_time);
-        }
-      }
-      else
-      {
-        // Time is up! Stop the thread pool as fast as possible.
-        pool.stop();
-        // Then break the while loop
-        break;
-      }
+      aggregator.push(producer, co_await client.do_request(*state), true);
+    }
+    aggregator.finish_warmup();
+
+    asio::steady_timer timer(co_await asio::this_coro::executor);
+    while (!aggregator.measuring())
+    {
+      timer.expires_after(std::chrono::milliseconds(1));
+      co_await timer.async_wait(asio::use_awaitable);
     }
   }
-  // Number of requests test?
-  else
+
+  const auto stop_time = aggregator.measurement_start() + duration;
+  for (int done = 0; (requests < 0) ? (std::chrono::steady_clock::now() < stop_time) : (done < requests); ++done)
   {
-    for (int i = 0; i < settings.requests; ++i)
+    aggregator.push(producer, co_await client.do_request(*state));
+  }
+  aggregator.finish_connection();
+}
+
+/**
+ * \brief Search the highest throughput that still meets the latency SLO
+ * \param settings The settings struct
+ * \param client The HTTP client, re-used for all trials
+ * \details First double the concurrency each trial until the SLO is violated (or the max. concurrency is reached),
+ * then binary search between the last passed and the first failed concurrency.
+ * Every trial starts with the warm-up (if any), the trial only measures after its own warm-up.
+ */
+void Handler::find_max(const Settings& settings, const Client& client)
+{
+  std::vector<TrialResult> curve;
+  auto trial = [&](std::size_t concurrency)
+  {
+    TrialResult result = Handler::run_trial(settings, client, concurrency);
+    curve.push_back(result);
+    if (!settings.silent)
+      Output::trial_progress(result);
+    return result.passed;
+  };
+
+  const std::size_t max_concurrency = std::max(1, settings.max_concurrency);
+  std::size_t passed = 0; // Highest concurrency that meets the SLO
+  std::size_t failed = 0; // Lowest concurrency that violates the SLO
+  for (std::size_t concurrency = 1;; concurrency = std::min(concurrency * 2, max_concurrency))
+  {
+    if (!trial(concurrency))
     {
-      asio::dispatch(pool, worker);
-      // Only do the below every 1000 requests, meaning less resources / CPU time
-      if (!settings.silent && (i % 1000) == 0)
-      {
-        int percentage = (i + 1) * 100 / settings.requests;
-        Output::display_progress_bar(percentage, -1, (settings.requests - i - 1));
-      }
+      failed = concurrency;
+      break;
     }
+    passed = concurrency;
+    if (concurrency == max_concurrency)
+      break;
   }
 
-  // Wait until all threads are finished
-  pool.join();
-  const auto end_test_time_point = std::chrono::steady_clock::now();
-  std::chrono::duration<double, std::milli> total_test_duration = end_test_time_point - start_test_time_point;
+  // Narrow down until a resolution of 5% (or a single worker)
+  if (failed > 0 && passed > 0)
+  {
+    while (failed - passed > std::max<std::size_t>(1, passed / 20))
+    {
+      std::size_t concurrency = passed + (failed - passed) / 2;
+      if (trial(concurrency))
+        passed = concurrency;
+      else
+        failed = concurrency;
+    }
+  }
+
+  // The highest sustainable throughput is not necessarily measured at the highest concurrency
+  const TrialResult* best = nullptr;
+  for (const auto& result : curve)
+  {
+    if (result.passed && (best == nullptr || result.requests_per_sec > best->requests_per_sec))
+      best = &result;
+  }
 
-  // Show test report
   if (!settings.silent)
   {
-    Output::display_progress_bar(100); // Always set to 100% now
-    Output::test_report(settings, total, total_test_duration);
+    Output::find_max_report(settings, curve, best);
   }
 }
+
+/**
+ * \brief Run a single duration trial and check the result against the SLO
+ * \param settings The settings struct
+ * \param client The HTTP client
+ * \param concurrency Number of workers during this trial
+ * \return Trial result
+ */
+TrialResult Handler::run_trial(const Settings& settings, const Client& client, std::size_t concurrency)
+{
+  Statistics statistics = Handler::run(settings, client, concurrency, 0, std::chrono::seconds(settings.trial_duration_sec), false, nullptr);
+  const std::chrono::duration<double> trial_duration = statistics.duration();
+
+  TrialResult result;
+  result.concurrency = concurrency;
+  // Only the successful requests, failed requests are no sustainable throughput
+  result.requests_per_sec = (statistics.requests() - statistics.errors()) / trial_duration.count();
+  result.latency = statistics.latency().percentile(settings.slo_percentile);
+  result.error_rate = statistics.error_rate() * 100.0;
+  result.passed = statistics.latency().count() > 0 && result.latency < settings.slo_latency_ms && result.error_rate < settings.slo_error_rate;
+  return result;
+}
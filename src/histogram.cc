@@ -0,0 +1,126 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+/**
+ * \brief Record a single value
+ * \param value Duration to record
+ */
+void Histogram::record(std::chrono::duration<double, std::milli> value)
+{
+  const double microseconds = std::max(value.count() * 1000.0, 0.0);
+  const std::uint64_t max_value = (std::uint64_t{1} << max_value_bits_) - 1;
+  const std::uint64_t clamped = std::min(static_cast<std::uint64_t>(std::llround(microseconds)), max_value);
+
+  ++buckets_[bucket_index(clamped)];
+  ++count_;
+  min_ = std::min(min_, clamped);
+  max_ = std::max(max_, clamped);
+  sum_ += microseconds;
+}
+
+/**
+ * \brief Add all the values of another histogram to this histogram
+ * \param other The other histogram
+ */
+void Histogram::merge(const Histogram& other)
+{
+  for (std::size_t i = 0; i < bucket_count_; ++i)
+  {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+}
+
+/**
+ * \brief Remove all recorded values
+ */
+void Histogram::reset()
+{
+  *this = Histogram();
+}
+
+/**
+ * \brief Lowest recorded value in ms (or zero when empty)
+ */
+double Histogram::min() const
+{
+  return (count_ == 0) ? 0.0 : min_ / 1000.0;
+}
+
+/**
+ * \brief Highest recorded value in ms
+ */
+double Histogram::max() const
+{
+  return max_ / 1000.0;
+}
+
+/**
+ * \brief Average of all recorded values in ms
+ */
+double Histogram::mean() const
+{
+  return (count_ == 0) ? 0.0 : (sum_ / count_) / 1000.0;
+}
+
+/**
+ * \brief Get the value at the given percentile
+ * \param percentile Percentile between 0 and 100 (eg. 99.9)
+ * \return Value in ms
+ */
+double Histogram::percentile(double percentile) const
+{
+  if (count_ == 0)
+    return 0.0;
+
+  const double clamped_percentile = std::clamp(percentile, 0.0, 100.0);
+  const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped_percentile / 100.0 * count_)));
+  std::uint64_t cumulative = 0;
+  for (std::size_t i = 0; i < bucket_count_; ++i)
+  {
+    cumulative += buckets_[i];
+    if (cumulative >= target)
+    {
+      // Never report a value outside of the recorded range
+      const double value = std::clamp(bucket_value(i), static_cast<double>(min_), static_cast<double>(max_));
+      return value / 1000.0;
+    }
+  }
+  return max();
+}
+
+/**
+ * \brief Get bucket index for a value (in microseconds)
+ */
+std::size_t Histogram::bucket_index(std::uint64_t value)
+{
+  constexpr std::uint64_t linear_limit = std::uint64_t{1} << (sub_bucket_bits_ + 1);
+  if (value < linear_limit)
+    return static_cast<std::size_t>(value);
+
+  // Shift the value so only the most significant bits remain, the shift itself selects the bucket range
+  const int shift = std::bit_width(value) - (sub_bucket_bits_ + 1);
+  return (static_cast<std::size_t>(shift) << sub_bucket_bits_) + static_cast<std::size_t>(value >> shift);
+}
+
+/**
+ * \brief Get the middle value (in microseconds) of the given bucket
+ */
+double Histogram::bucket_value(std::size_t index)
+{
+  constexpr std::size_t linear_limit = std::size_t{1} << (sub_bucket_bits_ + 1);
+  if (index < linear_limit)
+    return static_cast<double>(index);
+
+  const int shift = static_cast<int>(index >> sub_bucket_bits_) - 1;
+  const std::uint64_t sub_bucket = index - (static_cast<std::size_t>(shift) << sub_bucket_bits_);
+  const std::uint64_t lower = sub_bucket << shift;
+  const std::uint64_t upper = ((sub_bucket + 1) << shift) - 1;
+  return (lower + upper) / 2.0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include <cxxopts.hpp>
 #include <iostream>
 #include <string>
@@ -19,7 +21,7 @@ Settings process_arguments(const cxxopts::ParseResult& result, cxxopts::Options&
 
   if (result.count("version"))
   {
-    std::cout << "RamBam version " << PROJECT_VER << '\n';
+    std::cout << "RamBam version " << PROJECT_VER << " (I/O backend: " << PROJECT_IO_BACKEND << ")\n";
     exit(0);
   }
 
@@ -34,20 +36,131 @@ Settings process_arguments(const cxxopts::ParseResult& result, cxxopts::Options&
   settings.requests = result["requests"].as<int>();
   if (result.count("duration"))
     settings.duration_sec = result["duration"].as<int>();
+  if (result.count("warmup"))
+  {
+    // Number of requests (optionally ending with 'r', eg. 100r), or seconds when ending with 's' (eg. 5s)
+    const std::string warmup = result["warmup"].as<std::string>();
+    std::size_t pos = 0;
+    int value = -1;
+    try
+    {
+      value = std::stoi(warmup, &pos);
+    }
+    catch (const std::exception&)
+    {
+    }
+    const std::string unit = warmup.substr(pos);
+    if (value < 0 || (unit != "" && unit != "s" && unit != "r"))
+    {
+      std::cerr << "Error: Invalid warm-up: " << warmup << " (use eg. 5s for seconds or 100 or 100r for requests)" << std::endl;
+      exit(1);
+    }
+    if (unit == "s")
+      settings.warmup_sec = value;
+    else
+      settings.warmup_requests = value;
+  }
+  settings.async = result["async"].as<bool>();
+  settings.connections = result["connections"].as<int>();
   if (result.count("post"))
     settings.post_data = result["post"].as<std::string>();
+  if (result.count("host"))
+    settings.host = result["host"].as<std::string>();
+  if (result.count("body-file"))
+    settings.body_file = result["body-file"].as<std::string>();
+  if (!settings.post_data.empty() && !settings.body_file.empty())
+  {
+    std::cerr << "Error: The post and body-file options can not be combined" << std::endl;
+    exit(1);
+  }
+  if (result.count("method"))
+  {
+    settings.method = result["method"].as<std::string>();
+    std::transform(settings.method.begin(), settings.method.end(), settings.method.begin(), [](unsigned char c) { return std::toupper(c); });
+    if (settings.method != "GET" && settings.method != "POST" && settings.method != "PUT" && settings.method != "PATCH" &&
+        settings.method != "DELETE")
+    {
+      std::cerr << "Error: Unknown HTTP method: " << settings.method << " (use GET, POST, PUT, PATCH or DELETE)" << std::endl;
+      exit(1);
+    }
+  }
+  else
+  {
+    settings.method = (settings.post_data.empty() && settings.body_file.empty()) ? "GET" : "POST";
+  }
+  if (result.count("raw-log"))
+    settings.raw_log_file = result["raw-log"].as<std::string>();
   settings.verify_peer = !(result["disable-peer-verify"].as<bool>());
   settings.override_verify_tls = result["override-verify-tls"].as<bool>();
   settings.verbose = result["verbose"].as<bool>();
   settings.silent = result["silent"].as<bool>();
   settings.debug = result["debug"].as<bool>();
+  settings.tls_version = result["tls-version"].as<std::string>();
+  if (result.count("ciphers"))
+    settings.ciphers = result["ciphers"].as<std::string>();
+  if (result.count("ciphersuites"))
+    settings.ciphersuites = result["ciphersuites"].as<std::string>();
+  if (result.count("curves"))
+    settings.curves = result["curves"].as<std::string>();
+  settings.tls_resume = result["tls-resume"].as<bool>();
+  settings.connect_timeout_ms = result["connect-timeout"].as<int>();
+  settings.handshake_timeout_ms = result["handshake-timeout"].as<int>();
+  settings.first_byte_timeout_ms = result["first-byte-timeout"].as<int>();
+  settings.total_timeout_ms = result["timeout"].as<int>();
+
+  const std::string mode = result["mode"].as<std::string>();
+  if (mode.compare("http") == 0)
+    settings.mode = TestMode::Http;
+  else if (mode.compare("connect") == 0)
+    settings.mode = TestMode::Connect;
+  else if (mode.compare("handshake") == 0)
+    settings.mode = TestMode::Handshake;
+  else
+  {
+    std::cerr << "Error: Unknown test mode: " << mode << " (use http, connect or handshake)" << std::endl;
+    exit(1);
+  }
+  settings.find_max = result["find-max"].as<bool>();
+  settings.slo_latency_ms = result["slo-latency"].as<double>();
+  settings.slo_percentile = result["slo-percentile"].as<double>();
+  settings.slo_error_rate = result["slo-error-rate"].as<double>();
+  settings.trial_duration_sec = result["trial-duration"].as<int>();
+  settings.max_concurrency = result["max-concurrency"].as<int>();
+  if (settings.trial_duration_sec <= 0 || settings.max_concurrency <= 0)
+  {
+    std::cerr << "Error: The trial duration and the max. concurrency must be larger than zero" << std::endl;
+    exit(1);
+  }
+  if (result.count("save-baseline"))
+    settings.save_baseline_file = result["save-baseline"].as<std::string>();
+  if (result.count("compare"))
+    settings.compare_files = result["compare"].as<std::vector<std::string>>();
+  settings.regression_threshold = result["threshold"].as<double>();
+  settings.regression_noise_floor = result["noise-floor"].as<double>();
+  if (settings.find_max && (!settings.save_baseline_file.empty() || !settings.compare_files.empty()))
+  {
+    std::cerr << "Error: Baselines are not supported in find max. mode" << std::endl;
+    exit(1);
+  }
+  // The trials would all append to the same raw log, without a way to tell the trials apart
+  if (settings.find_max && !settings.raw_log_file.empty())
+  {
+    std::cerr << "Error: The raw log is not supported in find max. mode" << std::endl;
+    exit(1);
+  }
+  // The baseline tests use the values of every complete second (the last second is incomplete)
+  if ((!settings.save_baseline_file.empty() || !settings.compare_files.empty()) && settings.duration_sec < 3)
+  {
+    std::cerr << "Error: Baselines require a duration test of at least 3 seconds (-d)" << std::endl;
+    exit(1);
+  }
 
   if (result.count("urls"))
   {
     for (const std::string& url : result["urls"].as<std::vector<std::string>>())
     {
       // TODO: ... support multiple URLs
-      if (url.compare(0, 7, "http://") != 0 && url.compare(0, 8, "https://") != 0)
+      if (url.compare(0, 7, "http://") != 0 && url.compare(0, 8, "https://") != 0 && url.compare(0, 7, "unix://") != 0)
       {
         // Assume HTTPS
         settings.url = "https://" + url;
@@ -70,6 +183,11 @@ Settings process_arguments(const cxxopts::ParseResult& result, cxxopts::Options&
     //  std::cout << options.help() << std::endl;
     //  exit(0);
   }
+  if (settings.mode == TestMode::Handshake && settings.url.compare(0, 8, "https://") != 0)
+  {
+    std::cerr << "Error: The handshake test mode requires a HTTPS URL" << std::endl;
+    exit(1);
+  }
   return settings;
 }
 
@@ -86,11 +204,41 @@ int main(int argc, char* argv[])
     ("t,threads", "Number of threads, default: supported number of current threads of the hardware", cxxopts::value<int>()->default_value("0"))
     ("r,requests", "Total number of test requests", cxxopts::value<int>()->default_value("300"))
     ("d,duration", "Test duration in seconds", cxxopts::value<int>()) // Make this option the default, instead of requests
+    ("w,warmup",
+     "Warm-up before the measurement (and before each find max. trial), excluded from the results: number of requests (eg. 100 or 100r) "
+     "or seconds (eg. 5s)",
+     cxxopts::value<std::string>())
+    ("a,async", "Use the async engine, multiplexing the connections on the threads", cxxopts::value<bool>()->default_value("false"))
+    ("c,connections", "Number of concurrent connections (async engine only)", cxxopts::value<int>()->default_value("100"))
+    ("m,mode", "Test mode: http, connect (only TCP connect) or handshake (TCP connect + TLS handshake)", cxxopts::value<std::string>()->default_value("http"))
     ("p,post", "Post JSON data (request will be POST instead of GET)", cxxopts::value<std::string>())
+    ("X,method", "HTTP method: GET, POST, PUT, PATCH or DELETE (default: GET, or POST with a body)", cxxopts::value<std::string>())
+    ("host", "Host header of the requests (default: the host of the URL, localhost for a Unix domain socket)", cxxopts::value<std::string>())
+    ("body-file", "Send the content of the file as request body (request will be POST instead of GET)", cxxopts::value<std::string>())
+    ("connect-timeout", "Connect timeout in ms (0 = no timeout)", cxxopts::value<int>()->default_value("10000"))
+    ("handshake-timeout", "TLS handshake timeout in ms (0 = no timeout)", cxxopts::value<int>()->default_value("10000"))
+    ("first-byte-timeout", "Timeout in ms until the first byte of the response (0 = no timeout)", cxxopts::value<int>()->default_value("30000"))
+    ("timeout", "Total timeout of a request in ms (0 = no timeout), a duration test waits up to this timeout for the last requests", cxxopts::value<int>()->default_value("60000"))
+    ("raw-log", "Write every single result to a CSV file", cxxopts::value<std::string>())
     ("D,debug", "Enable debugging (eg. debug TLS)", cxxopts::value<bool>()->default_value("false"))
     ("disable-peer-verify", "Disable peer certificate verification", cxxopts::value<bool>()->default_value("false"))
     ("o,override-verify-tls", "Override TLS peer certificate verification", cxxopts::value<bool>()->default_value("false"))
-    ("urls", "URL(s) under test (space separated)", cxxopts::value<std::vector<std::string>>())
+    ("tls-version", "TLS version: 1.2 or 1.3", cxxopts::value<std::string>()->default_value("1.3"))
+    ("ciphers", "TLS v1.2 cipher list (OpenSSL format, eg. ECDHE-RSA-AES128-GCM-SHA256)", cxxopts::value<std::string>())
+    ("ciphersuites", "TLS v1.3 cipher suites (OpenSSL format, eg. TLS_AES_128_GCM_SHA256)", cxxopts::value<std::string>())
+    ("curves", "ECDHE curves / groups (eg. X25519:P-256)", cxxopts::value<std::string>())
+    ("tls-resume", "Resume the TLS session of the previous request on the same connection", cxxopts::value<bool>()->default_value("false"))
+    ("find-max", "Search the highest throughput that meets the latency SLO (see --slo-* options)", cxxopts::value<bool>()->default_value("false"))
+    ("slo-latency", "SLO latency in ms at the SLO percentile", cxxopts::value<double>()->default_value("200"))
+    ("slo-percentile", "SLO latency percentile", cxxopts::value<double>()->default_value("99"))
+    ("slo-error-rate", "SLO max. error rate in percentage", cxxopts::value<double>()->default_value("0.1"))
+    ("trial-duration", "Duration in seconds of each find max. trial", cxxopts::value<int>()->default_value("5"))
+    ("max-concurrency", "Highest concurrency tried during find max.", cxxopts::value<int>()->default_value("256"))
+    ("save-baseline", "Save the results (histograms and summary) to a binary baseline file", cxxopts::value<std::string>())
+    ("compare", "Compare the results with baseline file(s), multiple files (comma separated) are merged", cxxopts::value<std::vector<std::string>>())
+    ("threshold", "Max. regression in percentage before the comparison fails (exit code 1)", cxxopts::value<double>()->default_value("10"))
+    ("noise-floor", "Min. latency difference in ms before a latency metric can fail the comparison", cxxopts::value<double>()->default_value("1"))
+    ("urls", "URL(s) under test (space separated), eg. https://domain.tld/path or unix:///run/app.sock:/path", cxxopts::value<std::vector<std::string>>())
     ("version", "Show the version")
     ("h,help", "Print usage");
   // clang-format on 
@@ -103,7 +251,7 @@ int main(int argc, char* argv[])
     auto result = options.parse(argc, argv);
     Settings settings = process_arguments(result, options);
     // Start threads, it's a blocking call until all threads are finished or stopped
-    Handler::start(settings);
+    return Handler::start(settings);
   }
   catch (const cxxopts::exceptions::exception& error)
   {
@@ -0,0 +1,126 @@
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RAMBAM_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#include <fstream>
+#endif
+
+/**
+ * \brief Destructor, unmaps and closes the file
+ */
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+#ifdef RAMBAM_HAS_MMAP
+/**
+ * \brief Map the whole file into memory
+ * \param path Path of the file
+ * \return False when the file could not be opened or mapped
+ */
+bool MappedFile::open(const std::string& path)
+{
+  close();
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0)
+    return false;
+
+  struct stat file_status;
+  if (::fstat(fd_, &file_status) != 0 || !S_ISREG(file_status.st_mode))
+  {
+    close();
+    return false;
+  }
+  size_ = static_cast<std::size_t>(file_status.st_size);
+  // An empty file can not be mapped (and does not need to be)
+  if (size_ == 0)
+    return true;
+
+  data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data_ == MAP_FAILED)
+  {
+    data_ = nullptr;
+    close();
+    return false;
+  }
+  // Read the file into the page cache up front, instead of during the first requests
+  ::madvise(data_, size_, MADV_WILLNEED);
+  return true;
+}
+
+/**
+ * \brief Check if the file became smaller than the mapping
+ * \details Reading the mapping beyond the end of the file raises SIGBUS, so check this before reading the mapping.
+ */
+bool MappedFile::truncated() const
+{
+  struct stat file_status;
+  return fd_ >= 0 && (::fstat(fd_, &file_status) != 0 || static_cast<std::size_t>(file_status.st_size) < size_);
+}
+
+/**
+ * \brief Unmap and close the file
+ */
+void MappedFile::close()
+{
+  if (data_ != nullptr)
+    ::munmap(data_, size_);
+  if (fd_ >= 0)
+    ::close(fd_);
+  data_ = nullptr;
+  fd_ = -1;
+  size_ = 0;
+}
+#else
+/**
+ * \brief Read the whole file into memory (fallback without mmap())
+ * \param path Path of the file
+ * \return False when the file could not be opened or read
+ */
+bool MappedFile::open(const std::string& path)
+{
+  close();
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(path, error))
+    return false;
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file)
+    return false;
+
+  buffer_.resize(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  if (!file.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size())))
+  {
+    close();
+    return false;
+  }
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  return true;
+}
+
+/**
+ * \brief The buffer is a copy of the file, so it can never be truncated
+ */
+bool MappedFile::truncated() const
+{
+  return false;
+}
+
+/**
+ * \brief Release the buffer
+ */
+void MappedFile::close()
+{
+  std::vector<char>().swap(buffer_);
+  data_ = nullptr;
+  size_ = 0;
+}
+#endif
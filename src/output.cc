@@ -1,6 +1,11 @@
 #include "output.h"
+#include "allocation_counter.h"
+#include "project_config.h"
 #include "settings_struct.h"
+#include "statistics.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
@@ -47,6 +52,19 @@ void Output::display_progress_bar(int percentage, int remaining_time, int remain
 void Output::test_info(const std::size_t num_threads, const Settings& settings)
 {
   std::vector<std::vector<std::string>> info = {{"URL under test:", settings.url}};
+  if (settings.find_max)
+  {
+    // Find max. throughput test, the concurrency (threads or async connections) is changed for each trial
+    info.push_back({"Type of test:", "Find max. throughput"});
+    if (settings.async)
+      info.push_back({"Engine:", std::string("Async (") + PROJECT_IO_BACKEND + "), " + std::to_string(num_threads) + " threads"});
+    info.push_back({"SLO:", slo_description(settings)});
+    info.push_back({"Trial duration:", std::to_string(settings.trial_duration_sec) + " seconds"});
+    info.push_back({"Max. concurrency:", std::to_string(settings.max_concurrency)});
+    print_table(info);
+    std::cout << std::endl;
+    return;
+  }
   if (settings.duration_sec == 0)
   {
     // Number of Requests test
@@ -59,14 +77,38 @@ void Output::test_info(const std::size_t num_threads, const Settings& settings)
     info.push_back({"Type of test:", "Duration"});
     info.push_back({"Duration input:", std::to_string(settings.duration_sec) + " seconds"});
   }
+  if (settings.warmup_sec > 0)
+    info.push_back({"Warm-up:", std::to_string(settings.warmup_sec) + " seconds"});
+  else if (settings.warmup_requests > 0)
+    info.push_back({"Warm-up:", std::to_string(settings.warmup_requests) + " requests"});
+  if (settings.mode != TestMode::Http)
+  {
+    info.push_back({"Test mode:", mode_name(settings.mode)});
+  }
+  else if (settings.method != "GET")
+  {
+    info.push_back({"Method:", settings.method});
+  }
+  if (!settings.host.empty())
+    info.push_back({"Host header:", settings.host});
+  if (!settings.body_file.empty())
+    info.push_back({"Body file:", settings.body_file});
   info.push_back({"Threads:", std::to_string(num_threads)});
+  if (settings.async)
+  {
+    info.push_back({"Engine:", std::string("Async (") + PROJECT_IO_BACKEND + ")"});
+    info.push_back({"Connections:", std::to_string(settings.connections)});
+  }
   print_table(info);
 
   std::cout << std::endl;
 }
 
 // Print test report
-void Output::test_report(const Settings& settings, int total, std::chrono::duration<double, std::milli> total_test_duration)
+void Output::test_report(const Settings& settings,
+                         const Statistics& statistics,
+                         const Statistics& warmup,
+                         std::chrono::duration<double, std::milli> total_test_duration)
 {
   float total_seconds = total_test_duration.count() / 1000.0;
   std::vector<std::vector<std::string>> report = {{"Type of test:", (settings.duration_sec == 0) ? "Number of Requests" : "Duration"}};
@@ -74,21 +116,224 @@ void Output::test_report(const Settings& settings, int total, std::chrono::durat
   {
     // Number of Requests test
     report.push_back({"Request count input:", std::to_string(settings.requests)});
-    report.push_back({"Average reqs/sec:", to_string_with_precision(settings.requests / total_seconds)});
   }
   else
   {
     // Duration test
     report.push_back({"Duration input:", std::to_string(settings.duration_sec) + " s"});
-    report.push_back({"Total requests executed:", std::to_string(total)});
-    report.push_back({"Average reqs/sec:", to_string_with_precision(total / total_seconds)});
+    report.push_back({"Total requests executed:", std::to_string(statistics.requests())});
+  }
+  // The connect and handshake capacity only count the successful attempts
+  switch (settings.mode)
+  {
+  case TestMode::Connect:
+    report.push_back(
+        {"Average successful connects/sec:", to_string_with_precision((statistics.requests() - statistics.errors()) / total_seconds)});
+    break;
+  case TestMode::Handshake:
+    report.push_back({"Average successful handshakes/sec:", to_string_with_precision(statistics.handshakes() / total_seconds)});
+    break;
+  default:
+    report.push_back({"Average reqs/sec:", to_string_with_precision(statistics.requests() / total_seconds)});
+    break;
+  }
+  report.push_back(
+      {"Failed requests:", std::to_string(statistics.errors()) + " (" + to_string_with_precision(statistics.error_rate() * 100.0) + "%)"});
+  report.push_back({"Timed out requests:", std::to_string(statistics.timeouts())});
+  const Histogram& latency = statistics.latency();
+  report.push_back({"Latency min/avg/max:", to_string_with_precision(latency.min()) + " / " + to_string_with_precision(latency.mean()) + " / " +
+                                                 to_string_with_precision(latency.max()) + " ms"});
+  report.push_back({"Latency p50/p90/p99:", percentiles_description(latency)});
+  if (settings.mode != TestMode::Connect)
+  {
+    report.push_back({"Connect p50/p90/p99:", percentiles_description(statistics.connect())});
+  }
+  if (statistics.handshakes() > 0)
+  {
+    if (settings.mode != TestMode::Handshake)
+      report.push_back({"Handshakes/sec:", to_string_with_precision(statistics.handshakes() / total_seconds)});
+    report.push_back({"Handshake p50/p90/p99:", percentiles_description(statistics.handshake())});
+    const std::string resumed_ratio = to_string_with_precision(statistics.tls_resumed() * 100.0 / statistics.handshakes());
+    const std::string resumed_count = std::to_string(statistics.tls_resumed()) + " of " + std::to_string(statistics.handshakes());
+    report.push_back({"TLS resumption ratio:", resumed_ratio + "% (" + resumed_count + ")"});
+  }
+  if (settings.mode == TestMode::Http)
+  {
+    // Status line, headers and body of the responses, divided by the test duration
+    report.push_back({"Download throughput:", to_string_with_precision(statistics.bytes() / 1000000.0 / total_seconds) + " MB/s"});
+  }
+  if (settings.mode == TestMode::Http && (!settings.post_data.empty() || !settings.body_file.empty()))
+  {
+    // Request headers and body of the completed requests (got a response), divided by the test duration
+    report.push_back({"Upload throughput:", to_string_with_precision(statistics.bytes_sent() / 1000000.0 / total_seconds) + " MB/s"});
+  }
+  if (AllocationCounter::enabled() && statistics.requests() > 0)
+  {
+    report.push_back({"Heap allocations/request:", to_string_with_precision(static_cast<double>(statistics.allocations()) / statistics.requests())});
+  }
+  if (warmup.requests() > 0)
+  {
+    // Warm-up results are excluded from all the results above
+    report.push_back({"Warm-up requests:", std::to_string(warmup.requests()) + " (" + std::to_string(warmup.errors()) + " failed, excluded)"});
+    report.push_back({"Warm-up latency avg/p99:",
+                      to_string_with_precision(warmup.latency().mean()) + " / " + to_string_with_precision(warmup.latency().percentile(99)) + " ms"});
   }
   report.push_back({"Total test duration:", to_string_with_precision(total_test_duration.count(), 4) + " ms"});
 
+  // Show the throughput and latency over time in verbose mode
+  if (settings.verbose && !statistics.time_series().empty())
+  {
+    std::vector<std::vector<std::string>> time_series = {{"Second", "Requests", "Errors", "Avg. latency", "p99 latency", "Max. latency"}};
+    const auto& points = statistics.time_series();
+    for (std::size_t second = 0; second < points.size(); ++second)
+    {
+      const TimeSeriesPoint& point = points[second];
+      const double average = (point.responses == 0) ? 0.0 : point.latency_sum / point.responses;
+      time_series.push_back({std::to_string(second),
+                             std::to_string(point.requests),
+                             std::to_string(point.errors),
+                             to_string_with_precision(average) + " ms",
+                             to_string_with_precision(point.latency_p99) + " ms",
+                             to_string_with_precision(point.latency_max) + " ms"});
+    }
+    std::cout << std::endl;
+    print_table(time_series, "Time series");
+  }
+
   std::cout << std::endl;
   print_table(report, "Report", "Test Completed!");
 }
 
+/**
+ * \brief Print the result of a single find max. throughput trial
+ * \param result The trial result
+ */
+void Output::trial_progress(const TrialResult& result)
+{
+  std::cout << "Trial with concurrency " << result.concurrency << ": " << to_string_with_precision(result.requests_per_sec)
+            << " successful reqs/sec, latency " << to_string_with_precision(result.latency) << " ms, errors "
+            << to_string_with_precision(result.error_rate) << "% -> " << (result.passed ? "PASS" : "FAIL") << std::endl;
+}
+
+/**
+ * \brief Print the difference of each metric compared to the baseline, including the significance
+ * \param comparison The comparison of the current run against the baseline
+ */
+void Output::comparison_report(const Comparison& comparison)
+{
+  std::vector<std::vector<std::string>> table = {{"Metric", "Baseline", "Current", "Change", "p-value", "Result"}};
+  for (const auto& metric : comparison.metrics)
+  {
+    const double worse = metric.higher_is_better ? -metric.change : metric.change;
+    std::string result = "not significant";
+    if (metric.insufficient_samples)
+      result = "INSUFFICIENT SAMPLES";
+    else if (metric.regression)
+      result = "REGRESSION";
+    else if (metric.significant && worse < 0)
+      result = "improved";
+    else if (metric.significant)
+      result = metric.below_noise_floor ? "within noise floor" : "within threshold";
+    const std::string change = std::isinf(metric.change) ? "new" : ((metric.change > 0) ? "+" : "") + to_string_with_precision(metric.change) + "%";
+    table.push_back({metric.name,
+                     to_string_with_precision(metric.baseline) + " " + metric.unit,
+                     to_string_with_precision(metric.current) + " " + metric.unit,
+                     change,
+                     metric.insufficient_samples ? "-" : to_string_with_precision(metric.p_value, 4),
+                     result});
+  }
+  std::string verdict = comparison.regression ? "Regression detected" : "No regression";
+  if (comparison.insufficient_samples)
+    verdict += ", insufficient samples (at least 2 complete seconds are needed)";
+  const std::string footer = verdict + std::string(" (threshold: ") +
+                             to_string_with_precision(comparison.threshold) + "%, noise floor: " + to_string_with_precision(comparison.noise_floor) +
+                             " ms)";
+  std::cout << std::endl;
+  print_table(table, "Baseline comparison (" + std::to_string(comparison.baseline_runs) + " run(s))", footer);
+}
+
+/**
+ * \brief Print the measured throughput curve and the highest sustainable throughput
+ * \param settings The settings struct
+ * \param curve All trial results, in order of execution
+ * \param best The passed trial with the highest throughput, nullptr when no trial passed
+ */
+void Output::find_max_report(const Settings& settings, const std::vector<TrialResult>& curve, const TrialResult* best)
+{
+  // Show the curve ordered by concurrency (trials are executed out of order during the binary search)
+  std::vector<TrialResult> sorted_curve(curve);
+  std::sort(sorted_curve.begin(), sorted_curve.end(), [](const TrialResult& a, const TrialResult& b) { return a.concurrency < b.concurrency; });
+
+  std::ostringstream latency_header;
+  latency_header << "p" << settings.slo_percentile << " latency";
+  std::vector<std::vector<std::string>> table = {{"Concurrency", "Successful reqs/sec", latency_header.str(), "Error rate", "SLO"}};
+  for (const auto& result : sorted_curve)
+  {
+    table.push_back({std::to_string(result.concurrency),
+                     to_string_with_precision(result.requests_per_sec),
+                     to_string_with_precision(result.latency) + " ms",
+                     to_string_with_precision(result.error_rate) + "%",
+                     result.passed ? "PASS" : "FAIL"});
+  }
+  std::cout << std::endl;
+  print_table(table, "Measured curve (SLO: " + slo_description(settings) + ")");
+
+  std::vector<std::vector<std::string>> report;
+  if (best != nullptr)
+  {
+    report.push_back({"Max. sustainable successful reqs/sec:", to_string_with_precision(best->requests_per_sec)});
+    report.push_back({"At concurrency:", std::to_string(best->concurrency)});
+    report.push_back({latency_header.str() + ":", to_string_with_precision(best->latency) + " ms"});
+    report.push_back({"Error rate:", to_string_with_precision(best->error_rate) + "%"});
+  }
+  else
+  {
+    report.push_back({"Max. sustainable successful reqs/sec:", "None, SLO is not met at concurrency 1"});
+  }
+  report.push_back({"Trials executed:", std::to_string(curve.size())});
+
+  std::cout << std::endl;
+  print_table(report, "Report", "Test Completed!");
+}
+
+/**
+ * \brief Get the p50, p90 and p99 of a histogram as text
+ * \param histogram The histogram
+ */
+std::string Output::percentiles_description(const Histogram& histogram)
+{
+  return to_string_with_precision(histogram.percentile(50)) + " / " + to_string_with_precision(histogram.percentile(90)) + " / " +
+         to_string_with_precision(histogram.percentile(99)) + " ms";
+}
+
+/**
+ * \brief Get the name of the test mode
+ * \param mode The test mode
+ */
+std::string Output::mode_name(TestMode mode)
+{
+  switch (mode)
+  {
+  case TestMode::Connect:
+    return "Connect";
+  case TestMode::Handshake:
+    return "TLS handshake";
+  default:
+    return "HTTP";
+  }
+}
+
+/**
+ * \brief Get a human readable description of the SLO
+ * \param settings The settings struct
+ */
+std::string Output::slo_description(const Settings& settings)
+{
+  std::ostringstream out;
+  out << "p" << settings.slo_percentile << " < " << settings.slo_latency_ms << " ms, error rate < " << settings.slo_error_rate << "%";
+  return std::move(out).str();
+}
+
 void Output::print_table(const std::vector<std::vector<std::string>>& table, const std::string& header, const std::string& footer)
 {
   // Calculate column widths
@@ -0,0 +1,127 @@
+#include "statistics.h"
+
+#include <algorithm>
+
+/**
+ * \brief Constructor
+ */
+Statistics::Statistics()
+{
+  open_second_.fill(no_second_);
+}
+
+/**
+ * \brief Record the result of a single request
+ * \param record The result of the request
+ * \details Failed requests (eg. connection refused), timeouts and HTTP 5xx server errors are counted as errors,
+ * only requests that got a response are part of the latency histogram.
+ */
+void Statistics::record(const ResultRecord& record)
+{
+  const std::size_t second = record.timestamp / 1000;
+  if (second >= time_series_.size())
+    time_series_.resize(second + 1, TimeSeriesPoint{});
+  TimeSeriesPoint& point = time_series_[second];
+
+  ++requests_;
+  ++point.requests;
+  if (record.status != ResultStatus::Success)
+  {
+    ++errors_;
+    ++point.errors;
+    if (record.status == ResultStatus::Timeout)
+      ++timeouts_;
+    return;
+  }
+  // Only completed requests, a failed or timed out request may be sent or received partially
+  bytes_ += record.bytes;
+  bytes_sent_ += record.sent;
+  if (record.status_code >= 500)
+  {
+    ++errors_;
+    ++point.errors;
+  }
+
+  // Results of a second that is already complete (arrived too late) are only part of the totals
+  const std::size_t slot = open_slot(second);
+  const bool open = slot != no_second_;
+
+  connect_.record(std::chrono::microseconds(record.connect));
+  if (open)
+    second_connect_[slot].record(std::chrono::microseconds(record.connect));
+  if (record.handshake > 0)
+  {
+    handshake_.record(std::chrono::microseconds(record.handshake));
+    if (open)
+      second_handshake_[slot].record(std::chrono::microseconds(record.handshake));
+    ++handshakes_;
+    ++point.handshakes;
+    if (record.tls_resumed)
+      ++tls_resumed_;
+  }
+
+  const std::chrono::microseconds total(record.total);
+  latency_.record(total);
+  if (open)
+    second_latency_[slot].record(total);
+  const double total_ms = total.count() / 1000.0;
+  ++point.responses;
+  point.latency_sum += total_ms;
+  point.latency_max = std::max(point.latency_max, total_ms);
+}
+
+/**
+ * \brief Complete the time series, sets the percentiles of the seconds that are still open
+ * \details Call after the last result is recorded.
+ */
+void Statistics::finish()
+{
+  for (std::size_t slot = 0; slot < open_seconds_; ++slot)
+  {
+    close_slot(slot);
+  }
+}
+
+/**
+ * \brief Get the slot of the histograms of the given second, completes the oldest second if needed
+ * \param second Second of the result
+ * \return The slot, or no_second_ when the second is already complete
+ */
+std::size_t Statistics::open_slot(std::size_t second)
+{
+  const std::size_t slot = second % open_seconds_;
+  if (open_second_[slot] == second)
+    return slot;
+  if (open_second_[slot] != no_second_ && open_second_[slot] > second)
+    return no_second_;
+  close_slot(slot);
+  open_second_[slot] = second;
+  return slot;
+}
+
+/**
+ * \brief Store the percentiles of the second in the slot into the time series and empty the slot
+ */
+void Statistics::close_slot(std::size_t slot)
+{
+  if (open_second_[slot] == no_second_)
+    return;
+  TimeSeriesPoint& point = time_series_[open_second_[slot]];
+  point.latency_p50 = second_latency_[slot].percentile(50);
+  point.latency_p90 = second_latency_[slot].percentile(90);
+  point.latency_p99 = second_latency_[slot].percentile(99);
+  point.connect_p99 = second_connect_[slot].percentile(99);
+  point.handshake_p99 = second_handshake_[slot].percentile(99);
+  second_latency_[slot].reset();
+  second_connect_[slot].reset();
+  second_handshake_[slot].reset();
+  open_second_[slot] = no_second_;
+}
+
+/**
+ * \brief Get the ratio of failed requests (between 0.0 and 1.0)
+ */
+double Statistics::error_rate() const
+{
+  return (requests_ == 0) ? 0.0 : static_cast<double>(errors_) / requests_;
+}